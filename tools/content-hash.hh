@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "counter-rng.hh"
+
+//////////////////// Content hashes
+//
+// A fast, non-cryptographic 64-bit hash of a byte stream, to recognize files
+// with the same contents.  Words of 8 bytes are dealt in turn to four lanes,
+// each folding them in with the SplitMix64 finalizer, so that the lanes
+// proceed in parallel; the lanes and the length are mixed at the end.  The
+// result does not depend on how the stream is cut into update () calls.
+
+class content_hash {
+  public:
+    void update (std::string_view s) {
+      len += s.size ();
+      const char* p = s.data (), *end = p + s.size ();
+      if (nbuf) {
+        size_t k = std::min<size_t> (sizeof (buf) - nbuf, end - p);
+        std::memcpy (buf + nbuf, p, k);
+        nbuf += k, p += k;
+        if (nbuf < sizeof (buf))
+          return;
+        block (buf);
+        nbuf = 0;
+      }
+      for (; end - p >= (std::ptrdiff_t) sizeof (buf); p += sizeof (buf))
+        block (p);
+      std::memcpy (buf, p, end - p);
+      nbuf = end - p;
+    }
+
+    uint64_t digest () const {
+      uint64_t h[4] = { lane[0], lane[1], lane[2], lane[3] };
+      char tail[sizeof (buf)] = {};
+      std::memcpy (tail, buf, nbuf);
+      for (int i = 0; i < 4; ++i) {
+        uint64_t w;
+        std::memcpy (&w, tail + 8 * i, 8);
+        h[i] = mix64 (h[i] ^ w);
+      }
+      return mix64 (h[0] ^ mix64 (h[1] ^ mix64 (h[2] ^ mix64 (h[3] ^ len))));
+    }
+
+    static std::string hex (uint64_t h) {
+      std::string s (16, '0');
+      for (int i = 15; i >= 0; --i, h >>= 4)
+        s[i] = "0123456789abcdef"[h & 15];
+      return s;
+    }
+
+  private:
+    void block (const char* p) {
+      for (int i = 0; i < 4; ++i) {
+        uint64_t w;
+        std::memcpy (&w, p + 8 * i, 8);
+        lane[i] = mix64 (lane[i] ^ w);
+      }
+    }
+
+    uint64_t lane[4] = { 1, 2, 3, 4 };
+    uint64_t len = 0;
+    char buf[32];
+    size_t nbuf = 0;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+
+//////////////////// Counter-based random streams
+//
+// The n-th output of a stream is a pure function of the stream key and n, in
+// the style of SplitMix64: the output is the SplitMix64 finalizer applied to
+// key + (n + 1) * golden.  Keys are derived by hashing a tuple of integers,
+// e.g., (seed, game, vertex), so that any part of a random game can be
+// regenerated without replaying what comes before it.
+
+inline uint64_t mix64 (uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+class counter_rng {
+  public:
+    using result_type = uint64_t;
+
+    counter_rng (std::initializer_list<uint64_t> key_parts) {
+      for (auto p : key_parts)
+        key = mix64 (key ^ mix64 (p + golden));
+    }
+
+    static constexpr result_type min () { return 0; }
+    static constexpr result_type max () { return std::numeric_limits<result_type>::max (); }
+
+    result_type operator() () { return mix64 (key + ++ctr * golden); }
+
+    // Jump to the n-th output of the stream.
+    void seek (uint64_t n) { ctr = n; }
+
+    // Uniform integer in [0, range), range > 0.  Draws are masked to the bit
+    // width of range - 1 and rejected when too large, so that the result
+    // does not depend on the standard library implementation.
+    uint64_t below (uint64_t range) {
+      auto mask = range == 1 ? 0 : std::numeric_limits<uint64_t>::max () >> std::countl_zero (range - 1);
+      uint64_t r;
+      do
+        r = (*this) () & mask;
+      while (r >= range);
+      return r;
+    }
+
+    // Uniform integer in [lb, ub].
+    long uniform (long lb, long ub) {
+      return lb + (long) below ((uint64_t) ub - (uint64_t) lb + 1);
+    }
+
+  private:
+    static constexpr uint64_t golden = 0x9e3779b97f4a7c15ull;
+    uint64_t key = 0, ctr = 0;
+};
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+//////////////////// Compressed sparse row graphs
+//
+// Games are built by throwing edges in any order at a csr_builder, which
+// rejects duplicates and then lays out the successors of each vertex
+// contiguously and in increasing order.  This replaces one std::set per
+// vertex: the builder only holds a flat edge list and a duplicate detector.
+
+using vertex_t = uint32_t;
+
+struct csr_graph {
+    std::vector<uint64_t> offsets; // size nvertices + 1
+    std::vector<vertex_t> targets; // size nedges
+
+    size_t nvertices () const { return offsets.empty () ? 0 : offsets.size () - 1; }
+    size_t nedges () const { return targets.size (); }
+
+    std::span<const vertex_t> succ (size_t v) const {
+      return { targets.data () + offsets[v], targets.data () + offsets[v + 1] };
+    }
+};
+
+// Set of edges (from, to), encoded as from * nvertices + to.  When the whole
+// adjacency matrix is not much larger than a hash table holding the expected
+// edges, a plain bitset is used; otherwise an open-addressing hash table with
+// linear probing.
+class edge_set {
+  public:
+    edge_set (uint64_t nvertices, uint64_t expected_edges) : n (nvertices) {
+      // A hash slot is 64 bits and the table is kept at most half full.
+      use_bitset = n * n / 64 <= 4 * expected_edges + 1024;
+      if (use_bitset)
+        bits.resize ((n * n + 63) / 64);
+      else {
+        size_t cap = 1024;
+        while (cap < 2 * expected_edges) cap *= 2;
+        table.assign (cap, empty);
+      }
+    }
+
+    bool contains (uint64_t from, uint64_t to) const {
+      auto key = from * n + to;
+      if (use_bitset)
+        return bits[key / 64] >> (key % 64) & 1;
+      for (size_t i = slot (key); ; i = (i + 1) & (table.size () - 1)) {
+        if (table[i] == key) return true;
+        if (table[i] == empty) return false;
+      }
+    }
+
+    // Returns false if the edge was already there.
+    bool insert (uint64_t from, uint64_t to) {
+      auto key = from * n + to;
+      if (use_bitset) {
+        auto& w = bits[key / 64];
+        auto mask = uint64_t {1} << (key % 64);
+        if (w & mask) return false;
+        w |= mask;
+        return true;
+      }
+      if (2 * (size + 1) > table.size ())
+        grow ();
+      for (size_t i = slot (key); ; i = (i + 1) & (table.size () - 1)) {
+        if (table[i] == key) return false;
+        if (table[i] == empty) {
+          table[i] = key;
+          ++size;
+          return true;
+        }
+      }
+    }
+
+    void clear () {
+      if (use_bitset)
+        std::fill (bits.begin (), bits.end (), 0);
+      else
+        std::fill (table.begin (), table.end (), empty);
+      size = 0;
+    }
+
+  private:
+    static constexpr uint64_t empty = ~uint64_t {0};
+
+    size_t slot (uint64_t key) const {
+      // Fibonacci hashing, keeping the high bits of the product.
+      return (key * 0x9e3779b97f4a7c15ull) >> (64 - std::countr_zero (table.size ()));
+    }
+
+    void grow () {
+      std::vector<uint64_t> old (table.size () * 2, empty);
+      std::swap (old, table);
+      for (auto key : old)
+        if (key != empty)
+          for (size_t i = slot (key); ; i = (i + 1) & (table.size () - 1))
+            if (table[i] == empty) {
+              table[i] = key;
+              break;
+            }
+    }
+
+    uint64_t n;
+    bool use_bitset;
+    std::vector<uint64_t> bits, table;
+    size_t size = 0;
+};
+
+class csr_builder {
+  public:
+    csr_builder (uint64_t nvertices, uint64_t expected_edges) :
+      n (nvertices), seen (nvertices, expected_edges) {
+      edges.reserve (expected_edges);
+    }
+
+    bool contains (vertex_t from, vertex_t to) const { return seen.contains (from, to); }
+
+    // Returns false if the edge was already there.
+    bool insert (vertex_t from, vertex_t to) {
+      if (not seen.insert (from, to))
+        return false;
+      edges.push_back ({ from, to });
+      return true;
+    }
+
+    size_t nedges () const { return edges.size (); }
+
+    void clear () {
+      seen.clear ();
+      edges.clear ();
+    }
+
+    // Counting sort on the source, then sort each row.  The builder can be
+    // cleared and reused afterwards.
+    void build (csr_graph& g) const {
+      g.offsets.assign (n + 1, 0);
+      for (auto&& e : edges)
+        ++g.offsets[e.from + 1];
+      for (size_t v = 0; v < n; ++v)
+        g.offsets[v + 1] += g.offsets[v];
+
+      g.targets.resize (edges.size ());
+      std::vector<uint64_t> pos (g.offsets.begin (), g.offsets.end () - 1);
+      for (auto&& e : edges)
+        g.targets[pos[e.from]++] = e.to;
+      for (size_t v = 0; v < n; ++v)
+        std::sort (g.targets.begin () + g.offsets[v], g.targets.begin () + g.offsets[v + 1]);
+    }
+
+  private:
+    struct edge { vertex_t from, to; };
+    uint64_t n;
+    edge_set seen;
+    std::vector<edge> edges;
+};
+
+// Strongly connected components, with Tarjan's algorithm made iterative so
+// that long paths do not overflow the call stack.  comp[v] receives the
+// component of v; components are numbered in reverse topological order (a
+// component only reaches components with smaller or equal numbers).
+// Returns the number of components.
+inline size_t scc_decomposition (const csr_graph& g, std::vector<vertex_t>& comp) {
+  constexpr vertex_t unvisited = ~vertex_t {0};
+  size_t n = g.nvertices (), ncomp = 0;
+  comp.assign (n, unvisited);
+  std::vector<vertex_t> index (n, unvisited), low (n), stack;
+  std::vector<bool> on_stack (n);
+  // Call stack of the depth-first search: vertex, and next successor to try.
+  std::vector<std::pair<vertex_t, uint64_t>> calls;
+  vertex_t next_index = 0;
+
+  for (vertex_t root = 0; root < n; ++root) {
+    if (index[root] != unvisited)
+      continue;
+    calls.push_back ({ root, g.offsets[root] });
+    index[root] = low[root] = next_index++;
+    stack.push_back (root);
+    on_stack[root] = true;
+
+    while (not calls.empty ()) {
+      auto& [v, e] = calls.back ();
+      if (e < g.offsets[v + 1]) {
+        vertex_t w = g.targets[e++];
+        if (index[w] == unvisited) {
+          index[w] = low[w] = next_index++;
+          stack.push_back (w);
+          on_stack[w] = true;
+          calls.push_back ({ w, g.offsets[w] });
+        }
+        else if (on_stack[w])
+          low[v] = std::min (low[v], index[w]);
+        continue;
+      }
+
+      // All the successors of v are done.
+      vertex_t u = v;
+      calls.pop_back ();
+      if (not calls.empty ())
+        low[calls.back ().first] = std::min (low[calls.back ().first], low[u]);
+      if (low[u] == index[u]) {
+        vertex_t w;
+        do {
+          w = stack.back ();
+          stack.pop_back ();
+          on_stack[w] = false;
+          comp[w] = ncomp;
+        } while (w != u);
+        ++ncomp;
+      }
+    }
+  }
+  return ncomp;
+}
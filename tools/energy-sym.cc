@@ -0,0 +1,195 @@
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gmp.h>
+
+#include "energy-sym.hh"
+#include "pg-parser.hh"
+#include "power-table.hh"
+#include "text-writer.hh"
+
+#define die(S)                                  \
+  do {                                          \
+  std::cerr << S << "\n";                       \
+  exit (2);                                     \
+  } while (0)
+
+//////////////////// Symbolic energy games converter
+//
+// Converts energy games to the energy-sym dialect (see energy-sym.hh), and
+// back with -d.  The weights that are exactly (-B)^p or B^p, B being the
+// number of vertices or the base given with -b, are written as powers, and
+// the others are kept as they are; in particular, the weights of perturbed
+// games are not powers, and are better written by pg2energy and
+// friedmann-switch-best --format sym directly.
+//
+// A weight w with D digits can only be a power B^p for the one or two p such
+// that B^p has D digits; these powers are computed once, by a power_table,
+// and compared as text with w.  The weights that fit in an int64_t are
+// compared with the powers of B that do, including 1 = (-B)^0, so that the
+// games of friedmann-switch-best -e come out as with --format sym.
+
+void usage (char* prog) {
+  std::cerr << "usage: " << prog << " [-d] [-b BASE] GAME [OUTPUT]\n"
+            << "  Write an energy game with its weights (-BASE)^p as powers; see\n"
+            << "  energy-sym.hh for the format.  The output defaults to stdout.\n"
+            << "  -d: write a symbolic game (energy-sym) back in decimal.\n"
+            << "  -b: base of the powers (default: the number of vertices).\n";
+  exit (1);
+}
+
+void encode (const std::string& path, const pg_game& g, uint64_t base, text_writer& out) {
+  if (not g.energy) die (path << ": not an energy game");
+  if (base < 2) die (path << ": the base should be at least 2");
+
+  // Digits of the magnitude of a big label.
+  auto ndigits = [] (std::string_view s) { return s.size () - (s[0] == '-'); };
+  double digits_per_exp = std::log10 ((double) base);
+  auto candidates = [&] (std::string_view s) {
+    uint64_t d = ndigits (s);
+    return std::pair<uint64_t, uint64_t> ((d - 1) / digits_per_exp, d / digits_per_exp + 1);
+  };
+
+  std::vector<uint64_t> exps;
+  for (auto&& [_, s] : g.big_labels) {
+    auto [lo, hi] = candidates (s);
+    for (auto p = lo; p <= hi; ++p)
+      exps.push_back (p);
+  }
+  power_table powers (-(int64_t) base, exps);
+
+  // Writes l as (-B)^p or B^p if it is one, for a label that fits.
+  auto small_power = [&] (int64_t l) {
+    bool neg = l < 0;
+    uint64_t mag = neg ? -(uint64_t) l : l, m = 1; // m = B^p
+    for (uint64_t p = 0; m <= mag; ++p) {
+      if (m == mag and neg == (p % 2 == 1)) {
+        write_sym_weight (out, -(int64_t) base, p);
+        return true;
+      }
+      if (m == mag and not neg) {
+        write_sym_weight (out, base, p);
+        return true;
+      }
+      if (__builtin_mul_overflow (m, base, &m))
+        break;
+    }
+    return false;
+  };
+
+  out << "energy-sym " << g.nvertices () << ";\n";
+  if (g.start != PG_NO_START)
+    out << "start " << g.start << ";\n";
+  auto big = g.big_labels.begin ();
+  uint64_t npowers = 0;
+  for (vertex_t v = 0; v < g.nvertices (); ++v) {
+    out << v << ' ' << (int) g.owners[v] << ' ';
+    for (auto e = g.graph.offsets[v]; e < g.graph.offsets[v + 1]; ++e) {
+      if (e != g.graph.offsets[v]) out << ',';
+      out << g.graph.targets[e] << ' ';
+      if (big == g.big_labels.end () or big->first != e) {
+        if (small_power (g.labels[e]))
+          ++npowers;
+        else
+          out << g.labels[e];
+        continue;
+      }
+      auto s = (big++)->second;
+      auto [lo, hi] = candidates (s);
+      auto p = lo;
+      for (; p <= hi; ++p) {
+        auto t = powers.text (powers.index (p));
+        if (s == t) {
+          write_sym_weight (out, -(int64_t) base, p);
+          break;
+        }
+        if (t[0] == '-' and s == t.substr (1)) {
+          write_sym_weight (out, base, p);
+          break;
+        }
+      }
+      if (p > hi)
+        out << s;
+      else
+        ++npowers;
+    }
+    out << ";\n";
+  }
+  std::cerr << path << ": " << npowers << " of " << g.nedges () << " weights written as powers\n";
+}
+
+void decode (const sym_game& g, text_writer& out) {
+  std::map<int64_t, std::vector<uint64_t>> exps;
+  for (auto&& w : g.weights)
+    if (w.power ())
+      exps[w.base].push_back (w.exponent);
+  std::map<int64_t, std::unique_ptr<power_table>> powers;
+  for (auto&& [b, e] : exps)
+    powers[b] = std::make_unique<power_table> (b, e);
+
+  mpz_t z;
+  mpz_init (z);
+  out << "energy " << g.nvertices () << ";\n";
+  if (g.start != SYM_NO_START)
+    out << "start " << g.start << ";\n";
+  for (vertex_t v = 0; v < g.nvertices (); ++v) {
+    out << v << ' ' << (int) g.owners[v] << ' ';
+    for (auto e = g.graph.offsets[v]; e < g.graph.offsets[v + 1]; ++e) {
+      if (e != g.graph.offsets[v]) out << ',';
+      out << g.graph.targets[e] << ' ';
+      auto& w = g.weights[e];
+      if (not w.power ())
+        out << w.offset;
+      else if (w.offset.empty ()) {
+        auto& t = *powers[w.base];
+        out << t.text (t.index (w.exponent));
+      }
+      else {
+        sym_value (w, z);
+        out << (mpz_srcptr) z;
+      }
+    }
+    out << ";\n";
+  }
+  mpz_clear (z);
+}
+
+int main (int argc, char** argv) {
+  char* prog = argv[0];
+  bool to_decimal = false;
+  uint64_t base = 0;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "-d")
+      to_decimal = true;
+    else if (a == "-b" and i + 1 < argc)
+      base = std::stoul (argv[++i]);
+    else if (a.starts_with ("-"))
+      usage (prog);
+    else
+      files.push_back (a);
+  }
+  if (files.empty () or files.size () > 2) usage (prog);
+
+  mapped_file text;
+  if (not text.open (files[0])) die (files[0] << ": cannot open file");
+  std::string err;
+  pg_game g;
+  sym_game s;
+  if (to_decimal ? not parse_energy_sym (text.text (), s, err) : not parse_pg (text.text (), g, err, 0))
+    die (files[0] << ": " << err);
+
+  text_writer out = files.size () == 2 ? text_writer (files[1]) : text_writer (1);
+  if (not out.good ()) die (files[1] << ": cannot open file for writing");
+  if (to_decimal)
+    decode (s, out);
+  else
+    encode (files[0], g, base ? base : g.nvertices (), out);
+  if (not out.close ())
+    die ((files.size () == 2 ? files[1] : "stdout") << ": write error");
+}
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gmp.h>
+
+#include "csr-graph.hh"
+#include "text-writer.hh"
+
+//////////////////// Symbolic energy games
+//
+// The energy games obtained from parity games weigh their edges with powers
+// (-n)^p, which have thousands of digits.  The energy-sym dialect writes them
+// as powers instead, with an optional additive term, e.g., for a potential:
+//     energy-sym N;
+//     [start S;]
+//     id owner succ weight,succ weight,... ["name"];
+// where a weight is either a plain integer, or
+//     base^exponent[+offset|-offset]
+// with base an integer, in parentheses if negative, and exponent and offset
+// natural numbers: "(-63)^43", "(-63)^44-1208925819614629174706176", "12".
+// Vertices must be numbered 0 to n - 1, in any order.
+//
+// parse_energy_sym () reads such a file without evaluating the weights, so
+// that a solver working on the exponents never meets a bignum; sym_value ()
+// evaluates a weight.
+
+constexpr uint64_t SYM_NO_START = ~uint64_t {0};
+
+struct sym_weight {
+    int64_t base = 0;       // 0 for a plain integer
+    uint64_t exponent = 0;
+    std::string_view offset; // Decimal, with its sign if negative; empty for 0
+
+    bool power () const { return base != 0; }
+};
+
+struct sym_game {
+    uint64_t start = SYM_NO_START;
+    std::vector<uint8_t> owners;
+    csr_graph graph;                // successors in file order
+    std::vector<sym_weight> weights; // By edge
+
+    size_t nvertices () const { return owners.size (); }
+    size_t nedges () const { return graph.nedges (); }
+};
+
+// Writes base^exponent, plus offset if it is not empty or "0"; offset is
+// decimal, with its sign if negative.
+inline void write_sym_weight (text_writer& out, int64_t base, uint64_t exponent,
+                              std::string_view offset = {}) {
+  if (base < 0)
+    out << "(" << base << ")^" << exponent;
+  else
+    out << base << '^' << exponent;
+  if (offset.empty () or offset == "0")
+    return;
+  if (offset[0] != '-')
+    out << '+';
+  out << offset;
+}
+
+// z = base^exponent + offset.
+inline void sym_value (const sym_weight& w, mpz_t z) {
+  if (w.power ()) {
+    mpz_set_si (z, w.base);
+    mpz_pow_ui (z, z, w.exponent);
+  }
+  else
+    mpz_set_ui (z, 0);
+  if (w.offset.empty ())
+    return;
+  mpz_t o;
+  mpz_init_set_str (o, std::string (w.offset).c_str (), 10);
+  mpz_add (z, z, o);
+  mpz_clear (o);
+}
+
+inline bool parse_energy_sym (std::string_view text, sym_game& g, std::string& err) {
+  const char* p = text.data (), *end = p + text.size ();
+  auto fail = [&] (const std::string& what) {
+    err = "byte " + std::to_string (p - text.data ()) + ": " + what;
+    return false;
+  };
+  auto skip_space = [&] {
+    while (p != end and std::isspace ((unsigned char) *p))
+      ++p;
+  };
+  auto expect = [&] (char c) {
+    skip_space ();
+    if (p == end or *p != c)
+      return false;
+    ++p;
+    return true;
+  };
+  auto number = [&] (auto& x) {
+    skip_space ();
+    auto [q, ec] = std::from_chars (p, end, x);
+    if (ec != std::errc ())
+      return false;
+    p = q;
+    return true;
+  };
+  // Digits with an optional sign, left as text.
+  auto digits = [&] (std::string_view& s) {
+    const char* q = p;
+    if (p != end and (*p == '-' or *p == '+'))
+      ++p;
+    const char* d = p;
+    while (p != end and std::isdigit ((unsigned char) *p))
+      ++p;
+    s = { q, (size_t) (p - q) };
+    if (not s.empty () and s[0] == '+')
+      s.remove_prefix (1);
+    return p != d;
+  };
+
+  skip_space ();
+  if (not std::string_view (p, end).starts_with ("energy-sym"))
+    return fail ("expected energy-sym");
+  p = (const char*) std::memchr (p, ';', end - p);
+  if (not p)
+    return fail ("expected ;");
+  ++p;
+  g = sym_game ();
+
+  std::vector<uint64_t> ids, first_edge;
+  std::vector<uint8_t> owners;
+  std::vector<vertex_t> targets;
+  std::vector<sym_weight> weights;
+  while (skip_space (), p != end) {
+    if (std::string_view (p, end).starts_with ("start")) {
+      p += 5;
+      if (not number (g.start) or not expect (';'))
+        return fail ("bad start line");
+      continue;
+    }
+    uint64_t id;
+    unsigned owner;
+    if (not number (id) or not number (owner) or owner > 1)
+      return fail ("expected vertex number and owner");
+    ids.push_back (id);
+    owners.push_back (owner);
+    first_edge.push_back (targets.size ());
+    skip_space ();
+    while (p != end and std::isdigit ((unsigned char) *p)) {
+      vertex_t t;
+      sym_weight w;
+      if (not number (t))
+        return fail ("expected successor");
+      skip_space ();
+      const char* q = p;
+      bool paren = p != end and *p == '(';
+      if (not paren and not digits (w.offset))
+        return fail ("expected weight");
+      if (paren or (p != end and *p == '^')) {
+        // A power: read the base again, as a number.
+        p = q + paren;
+        if (not number (w.base) or w.base == 0 or (w.base < 0) != paren
+            or (paren and not expect (')')) or not expect ('^') or not number (w.exponent))
+          return fail ("expected base^exponent");
+        w.offset = {};
+        if (p != end and (*p == '+' or *p == '-') and not digits (w.offset))
+          return fail ("expected offset");
+      }
+      targets.push_back (t);
+      weights.push_back (w);
+      skip_space ();
+      if (p != end and *p == ',')
+        ++p, skip_space ();
+    }
+    if (p != end and *p == '"') {
+      p = (const char*) std::memchr (p + 1, '"', end - p - 1);
+      if (not p)
+        return fail ("unterminated name");
+      ++p;
+    }
+    if (not expect (';'))
+      return fail ("expected ;");
+  }
+  first_edge.push_back (targets.size ());
+
+  // Lay out the vertices by number.
+  uint64_t n = ids.size ();
+  std::vector<uint64_t> line_of (n, SYM_NO_START);
+  for (uint64_t l = 0; l < n; ++l) {
+    if (ids[l] >= n)
+      return fail ("vertex " + std::to_string (ids[l]) + " out of range");
+    if (line_of[ids[l]] != SYM_NO_START)
+      return fail ("vertex " + std::to_string (ids[l]) + " defined twice");
+    line_of[ids[l]] = l;
+  }
+  g.owners.resize (n);
+  g.graph.offsets.resize (n + 1);
+  g.graph.targets.reserve (targets.size ());
+  g.weights.reserve (weights.size ());
+  for (uint64_t v = 0; v < n; ++v) {
+    auto l = line_of[v];
+    g.owners[v] = owners[l];
+    g.graph.offsets[v] = g.graph.targets.size ();
+    for (auto e = first_edge[l]; e < first_edge[l + 1]; ++e) {
+      if (targets[e] >= n)
+        return fail ("successor " + std::to_string (targets[e]) + " out of range");
+      g.graph.targets.push_back (targets[e]);
+      g.weights.push_back (weights[e]);
+    }
+  }
+  g.graph.offsets[n] = g.graph.targets.size ();
+  if (g.start != SYM_NO_START and g.start >= n)
+    return fail ("start vertex out of range");
+  return true;
+}
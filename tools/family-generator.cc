@@ -0,0 +1,406 @@
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "csr-graph.hh"
+#include "pgb.hh"
+#include "text-writer.hh"
+
+using prio_t = int64_t;
+
+#define die(S)                                  \
+  do {                                          \
+  std::cerr << S << "\n";                       \
+  exit (2);                                     \
+  } while (0)
+
+//////////////////// Games of a family
+//
+// A family builds its game vertex by vertex, at numbers it computes itself,
+// and throws the edges at a csr_builder; an edge given twice is a bug in the
+// family.  The successors are written sorted, whereas the games of the
+// collection list them in no particular order.
+
+struct game {
+    std::vector<prio_t> prio;
+    std::vector<uint8_t> owner;
+    std::vector<std::string> names; // By vertex; empty for no name
+    csr_builder edges;
+
+    game (uint64_t nvertices, uint64_t expected_edges) :
+      prio (nvertices), owner (nvertices), names (nvertices), edges (nvertices, expected_edges) {
+      if (nvertices >= (uint64_t {1} << 32)) die ("too many vertices: " << nvertices);
+    }
+
+    size_t nvertices () const { return prio.size (); }
+
+    void vertex (vertex_t v, int o, prio_t p, std::string name = {}) {
+      owner[v] = o;
+      prio[v] = p;
+      names[v] = std::move (name);
+    }
+
+    void edge (vertex_t from, vertex_t to) {
+      if (not edges.insert (from, to)) die ("duplicate edge " << from << " -> " << to);
+    }
+};
+
+//////////////////// Two counters (plus)
+//
+// The game of the collection on which Tangle Learning and Recursive Tangle
+// Learning are exponential.  Each player p (Even, then Odd) has, for each
+// level i < N, a block with a head H, an entry I and a hub T, and for each
+// level j >= i, a chain of i switches (S, choosing between A and B), ended
+// by Z.  The A of switch k goes to I of level k of p, its B to I of level k
+// of the other player, and the Z of level j > i to I of level j of the other
+// player.  The blocks are laid out level by level, Even first, and the
+// vertices are named as in the collection, e.g., "Odd-1-2-S-0".
+//
+// With N = 1, there are no switches, and the priorities 1 and 2 they would
+// use are left out by shifting the other ones down by 2.
+
+game two_counter_plus (const std::vector<uint64_t>& params) {
+  uint64_t n = params[0];
+  // Size of the block of one player at level i, and its first vertex.
+  auto block_size = [&] (uint64_t i) { return 3 + (n - i) * (3 * i + 1); };
+  std::vector<uint64_t> start (2 * n + 1);
+  for (uint64_t i = 0; i < n; ++i)
+    for (int p = 0; p < 2; ++p)
+      start[2 * i + p + 1] = start[2 * i + p] + block_size (i);
+
+  auto block = [&] (uint64_t i, int p) { return start[2 * i + p]; };
+  auto head = [&] (uint64_t i, int p) { return block (i, p); };
+  auto entry = [&] (uint64_t i, int p) { return block (i, p) + 1; };
+  auto hub = [&] (uint64_t i, int p) { return block (i, p) + 2; };
+  // First vertex of the chain of level j in the block (i, p): switch k is at
+  // +3k (S), +3k+1 (A), +3k+2 (B), and Z at +3i.
+  auto chain = [&] (uint64_t i, int p, uint64_t j) { return block (i, p) + 3 + (j - i) * (3 * i + 1); };
+
+  game g (start[2 * n], 3 * start[2 * n]);
+  prio_t shift = n == 1 ? 2 : 0;
+  const char* player[2] = { "Even", "Odd" };
+  for (uint64_t i = 0; i < n; ++i)
+    for (int p = 0; p < 2; ++p) {
+      auto prefix = std::string (player[p]) + "-" + std::to_string (i) + "-";
+      g.vertex (head (i, p), p, 6*n + 3 - 2*i + (p == 0) - shift, prefix + "H");
+      g.edge (head (i, p), entry ((i + n - 1) % n, p));
+      g.vertex (entry (i, p), 1 - p, 4*n + 2 - 2*i + (p == 0) - shift, prefix + "I");
+      g.edge (entry (i, p), hub (i, p));
+      g.vertex (hub (i, p), 1 - p, 2 + p - shift, prefix + "T");
+      g.edge (hub (i, p), head (i, p));
+
+      for (uint64_t j = i; j < n; ++j) {
+        auto c = chain (i, p, j), z = c + 3 * i;
+        auto name = j == i ? prefix : prefix + std::to_string (j) + "-";
+        g.edge (hub (i, p), c);
+        for (uint64_t k = 0; k < i; ++k) {
+          auto s = c + 3 * k, next = k + 1 < i ? s + 3 : z;
+          auto num = std::to_string (k);
+          g.vertex (s, p, 1 + p, name + "S-" + num);
+          g.edge (s, s + 1);
+          g.edge (s, s + 2);
+          g.vertex (s + 1, 1 - p, 1 + p, name + "A-" + num);
+          g.edge (s + 1, next);
+          g.edge (s + 1, entry (k, p));
+          g.vertex (s + 2, 1 - p, 1 + p, name + "B-" + num);
+          g.edge (s + 2, next);
+          g.edge (s + 2, entry (k, 1 - p));
+        }
+        g.vertex (z, p, 4 + 2 * (j - i) + p - shift, name + "Z");
+        g.edge (z, hub (i, p));
+        if (j > i)
+          g.edge (z, entry (j, 1 - p));
+      }
+    }
+  return g;
+}
+
+//////////////////// Arenas
+//
+// The ladder games and the Jurdzinski games of the collection are not the
+// PGSolver games themselves, but their translation to a three-layer arena,
+// as done for the SYNTCOMP games.  Each vertex v of the original game is a
+// state (owner 1, priority 0) named "v", or "initial" for vertex 0.  A state
+// moves to choices (owner 0, priority 0), which move to transitions (owner
+// 1), each going to a single state t with the priority of t.  A vertex of
+// player 1 has one choice per successor, and a vertex of player 0 a single
+// choice of all its successors.  The choices with the same transitions are
+// one vertex, as are the transitions to the same state.  They follow the
+// states, numbered in the order they are first met, visiting the states by
+// number and their successors in increasing order; the collection numbers
+// them in another order, and names them after internal numbers of the tool
+// that made them, so the games are the same up to this numbering.
+
+game arena (const game& orig) {
+  csr_graph g;
+  orig.edges.build (g);
+  uint64_t m = g.nvertices ();
+
+  constexpr vertex_t none = ~vertex_t {0};
+  std::vector<vertex_t> trans (m, none); // Transition to each state
+  std::vector<vertex_t> trans_target;
+  std::map<std::vector<vertex_t>, vertex_t> choices; // Transitions -> choice
+  std::vector<std::vector<vertex_t>> moves (m);       // Choices of each state
+  uint64_t nedges = 0;
+
+  auto transition = [&] (vertex_t t) {
+    if (trans[t] == none) {
+      trans[t] = trans_target.size ();
+      trans_target.push_back (t);
+    }
+    return trans[t];
+  };
+  auto choice = [&] (std::vector<vertex_t>&& ts) {
+    auto [it, fresh] = choices.emplace (std::move (ts), choices.size ());
+    if (fresh)
+      nedges += it->first.size ();
+    return it->second;
+  };
+  for (vertex_t v = 0; v < m; ++v) {
+    if (orig.owner[v] == 1)
+      for (auto t : g.succ (v))
+        moves[v].push_back (choice ({ transition (t) }));
+    else {
+      std::vector<vertex_t> ts;
+      for (auto t : g.succ (v))
+        ts.push_back (transition (t));
+      moves[v].push_back (choice (std::move (ts)));
+    }
+    nedges += moves[v].size ();
+  }
+
+  uint64_t first_choice = m, first_trans = m + choices.size ();
+  uint64_t n = first_trans + trans_target.size ();
+  game a (n, nedges + trans_target.size ());
+  for (vertex_t v = 0; v < m; ++v) {
+    a.vertex (v, 1, 0, v == 0 ? "initial" : std::to_string (v));
+    for (auto c : moves[v])
+      a.edge (v, first_choice + c);
+  }
+  for (auto&& [ts, c] : choices) {
+    a.vertex (first_choice + c, 0, 0);
+    for (auto t : ts)
+      a.edge (first_choice + c, first_trans + t);
+  }
+  for (vertex_t t = 0; t < trans_target.size (); ++t) {
+    a.vertex (first_trans + t, 1, orig.prio[trans_target[t]]);
+    a.edge (first_trans + t, trans_target[t]);
+  }
+  return a;
+}
+
+//////////////////// Ladder games
+//
+// Model checker ladder: vertex 0, then N rungs of three vertices b + 1, b + 2,
+// b + 3 (b = 3i): b + 1 (player 1, priority 2) goes to b + 2 (priority
+// 2N - 2i + 1) or b + 3 (priority 2N - 2i), and both go on to b + 3, then to
+// the next rung.  The last rung goes back to vertex 0, of priority 2N + 2.
+//
+// Recursive ladder: N rungs of five vertices b to b + 4 (b = 5h), owned
+// alternately by the players, starting with player 1 on even rungs.  Their
+// priorities are 3h + 7, 3h + 6, 3h + 5 and, for the last two, 2 on even
+// rungs and 3 on odd ones.  b + 1 is linked to the b + 1 of the rungs around.
+
+game mcladder (const std::vector<uint64_t>& params) {
+  uint64_t n = params[0];
+  game g (3 * n + 1, 4 * n + 1);
+  g.vertex (0, 0, 2*n + 2);
+  g.edge (0, 1);
+  for (uint64_t i = 0; i < n; ++i) {
+    vertex_t b = 3 * i;
+    g.vertex (b + 1, 1, 2);
+    g.edge (b + 1, b + 2);
+    g.edge (b + 1, b + 3);
+    g.vertex (b + 2, 0, 2*n - 2*i + 1);
+    g.edge (b + 2, b + 3);
+    g.vertex (b + 3, 0, 2*n - 2*i);
+    g.edge (b + 3, i + 1 < n ? b + 4 : 0);
+  }
+  return arena (g);
+}
+
+game rladder (const std::vector<uint64_t>& params) {
+  uint64_t n = params[0];
+  game g (5 * n, 12 * n);
+  for (uint64_t h = 0; h < n; ++h) {
+    vertex_t b = 5 * h;
+    bool last = h + 1 == n;
+    prio_t prio[5] = { prio_t (3*h + 7), prio_t (3*h + 6), prio_t (3*h + 5), prio_t (2 + h % 2), prio_t (2 + h % 2) };
+    for (int i = 0; i < 5; ++i)
+      g.vertex (b + i, (i + h + 1) % 2, prio[i]);
+    for (int i : { 0, 2, 3 }) {
+      g.edge (b + i, b + 1);
+      g.edge (b + i, b + 4);
+    }
+    g.edge (b + 1, b + 2);
+    if (h > 0) g.edge (b + 1, b - 4);
+    if (not last) g.edge (b + 1, b + 6);
+    g.edge (b + 4, b + 3);
+    if (not last) g.edge (b + 4, b + 5);
+  }
+  return arena (g);
+}
+
+//////////////////// Jurdzinski games
+//
+// jgame N M: vertex 0, then M rows r of a hub (player 1, priority 3) and N
+// vertices (r, k) of priority 2k, then, for each k >= 2, a gadget of 2M + 1
+// vertices linking the vertices (r, k) of consecutive rows.  Hub r goes to
+// the vertices of its row, and back through (r - 1, 1), or vertex 0 for the
+// first row; (r, 1) goes to hubs r and r + 1, and (r, k) to hub r and to the
+// gadget.  The gadget numbers the rows from the last one: row t = M - 1 - r
+// owns A_t (player 1, priority 2k), going to (r, k), (r - 1, k) and B_t
+// (priority 2k + 1), which goes back to (r, k).  (r, k) goes to A_t and
+// A_{t-1}, and the last row to A_0 and C (priority 2k), with C going back.
+
+game jgame (const std::vector<uint64_t>& params) {
+  uint64_t n = params[0], m = params[1];
+  uint64_t gadgets = 1 + m * (n + 1);
+  auto hub = [&] (uint64_t r) { return 1 + (n + 1) * r; };
+  auto row = [&] (uint64_t r, uint64_t k) { return hub (r) + k; };
+  auto gadget = [&] (uint64_t k) { return gadgets + (k - 2) * (2 * m + 1); };
+  auto a = [&] (uint64_t k, uint64_t t) { return gadget (k) + (t == 0 ? 0 : 2 * t + 1); };
+  auto b = [&] (uint64_t k, uint64_t t) { return gadget (k) + (t == 0 ? 2 : 2 * t + 2); };
+  auto c = [&] (uint64_t k) { return gadget (k) + 1; };
+
+  game g (gadgets + (n - 1) * (2 * m + 1), 1 + m * (4 * n + 1) + (n - 1) * (4 * m + 1));
+  g.vertex (0, 0, 2);
+  g.edge (0, hub (0));
+  for (uint64_t r = 0; r < m; ++r) {
+    g.vertex (hub (r), 1, 3);
+    g.edge (hub (r), r == 0 ? 0 : row (r - 1, 1));
+    for (uint64_t k = 1; k <= n; ++k) {
+      g.edge (hub (r), row (r, k));
+      g.vertex (row (r, k), 0, 2 * k);
+      g.edge (row (r, k), hub (r));
+      uint64_t t = m - 1 - r;
+      if (k == 1) {
+        if (r + 1 < m) g.edge (row (r, k), hub (r + 1));
+        continue;
+      }
+      g.edge (row (r, k), a (k, t));
+      g.edge (row (r, k), t == 0 ? c (k) : a (k, t - 1));
+    }
+  }
+  for (uint64_t k = 2; k <= n; ++k) {
+    g.vertex (c (k), 0, 2 * k);
+    g.edge (c (k), row (m - 1, k));
+    for (uint64_t t = 0; t < m; ++t) {
+      uint64_t r = m - 1 - t;
+      g.vertex (a (k, t), 1, 2 * k);
+      g.edge (a (k, t), b (k, t));
+      g.edge (a (k, t), row (r, k));
+      if (r > 0) g.edge (a (k, t), row (r - 1, k));
+      g.vertex (b (k, t), 0, 2 * k + 1);
+      g.edge (b (k, t), row (r, k));
+    }
+  }
+  return arena (g);
+}
+
+//////////////////// Registry
+
+struct family {
+    const char* name;
+    std::vector<const char*> params;
+    const char* description;
+    game (*build) (const std::vector<uint64_t>&);
+};
+
+const family families[] = {
+  { "two-counter-plus", { "N" }, "two counters, N levels", two_counter_plus },
+  { "mcladdergame", { "N" }, "model checker ladder, N rungs", mcladder },
+  { "rladdergame", { "N" }, "recursive ladder, N rungs", rladder },
+  { "jgame", { "N", "M" }, "Jurdzinski game, N levels and M rows", jgame },
+};
+
+void usage (char* prog) {
+  std::cerr << "usage: " << prog << " [--format pg|pgb] FAMILY PARAMS... [OUTPUT]\n"
+            << "  Generate a game of a synthetic family of the collection, of any size;\n"
+            << "  see family-generator.cc.  The output (default: stdout) is in PGSolver\n"
+            << "  text (pg, the default) or binary (pgb, without the vertex names).\n"
+            << "  Families:\n";
+  for (auto&& f : families) {
+    std::string line = f.name;
+    for (auto p : f.params)
+      line += std::string (" ") + p;
+    line.resize (std::max<size_t> (line.size () + 1, 24), ' ');
+    std::cerr << "    " << line << f.description << "\n";
+  }
+  exit (1);
+}
+
+int main (int argc, char** argv) {
+  char* prog = argv[0];
+  bool pgb = false;
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--format" and i + 1 < argc) {
+      std::string f = argv[++i];
+      if (f != "pg" and f != "pgb") usage (prog);
+      pgb = f == "pgb";
+    }
+    else if (a.starts_with ("-"))
+      usage (prog);
+    else
+      args.push_back (a);
+  }
+  if (args.empty ()) usage (prog);
+
+  const family* fam = nullptr;
+  for (auto&& f : families)
+    if (args[0] == f.name)
+      fam = &f;
+  if (not fam) usage (prog);
+  size_t nparams = fam->params.size ();
+  if (args.size () != nparams + 1 and args.size () != nparams + 2) usage (prog);
+
+  std::vector<uint64_t> params;
+  for (size_t i = 1; i <= nparams; ++i) {
+    uint64_t p = std::stoul (args[i]);
+    if (p == 0) die (fam->name << ": " << fam->params[i - 1] << " should be at least 1");
+    params.push_back (p);
+  }
+  game g = fam->build (params);
+  csr_graph graph;
+  g.edges.build (graph);
+
+  text_writer out = args.size () == nparams + 2 ? text_writer (args.back ()) : text_writer (1);
+  if (not out.good ()) die (args.back () << ": cannot open file for writing");
+  if (pgb) {
+    pgb_writer bin (PGB_PARITY, false);
+    for (vertex_t v = 0; v < g.nvertices (); ++v) {
+      bin.vertex (g.owner[v]);
+      bin.label (g.prio[v]);
+      for (auto t : graph.succ (v))
+        bin.edge (t);
+    }
+    bin.write (out);
+  }
+  else {
+    out << "parity " << g.nvertices () << ";\n";
+    for (vertex_t v = 0; v < g.nvertices (); ++v) {
+      out << v << ' ' << g.prio[v] << ' ' << (int) g.owner[v] << ' ';
+      bool first = true;
+      for (auto t : graph.succ (v)) {
+        if (not first) out << ',';
+        out << t;
+        first = false;
+      }
+      if (not g.names[v].empty ())
+        out << " \"" << g.names[v] << '"';
+      out << ";\n";
+    }
+  }
+  if (not out.close ())
+    die ((args.size () == nparams + 2 ? args.back () : "stdout") << ": write error");
+
+  prio_t highest = 0;
+  for (auto p : g.prio)
+    highest = std::max (highest, p);
+  std::cerr << fam->name << ": " << g.nvertices () << " vertices, " << graph.nedges ()
+            << " edges, priomax=" << highest << "\n";
+}
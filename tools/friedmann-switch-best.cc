@@ -1,10 +1,17 @@
+#include <algorithm>
 #include <iostream>
-#include <map>
+#include <numeric>
+#include <optional>
 #include <string>
-#include <set>
+#include <vector>
 
-#include <boost/random.hpp>
-#include <boost/multiprecision/gmp.hpp>
+#include "csr-graph.hh"
+#include "energy-sym.hh"
+#include "parallel.hh"
+#include "pgb.hh"
+#include "potential.hh"
+#include "power-table.hh"
+#include "text-writer.hh"
 
 using prio_t = ssize_t;
 
@@ -14,26 +21,67 @@ using prio_t = ssize_t;
   exit (2);                                     \
   } while (0)
 
-std::map<std::string, std::pair<prio_t, int>> nodes;
-std::map<std::string, std::set<std::string>> trans;
+//////////////////// Vertex layout
+//
+// The vertices come in blocks, t_i, a_i, c, d1_i, and so on, and vertex i of
+// a block (from 1, as in the thesis) is numbered arithmetically from the start
+// of its block.  The games are written with the vertices numbered in the
+// lexicographic order of their names, as in the files of the collection;
+// this permutation is computed once by sorting the 21n names, and edges are
+// then kept in a flat list of output numbers.
+
+enum block { T, A, C, D1, D2, D3, E, Y, G, K, F, H, S, R, X, nblocks };
+const char* block_name[nblocks] = { "t", "a", "c", "d1_", "d2_", "d3_", "e", "y", "g", "k",
+                                    "f", "h", "s", "r", "x" };
+
+size_t block_start[nblocks + 1];
+std::vector<std::string> names;  // By vertex
+std::vector<vertex_t> rank;      // Output number of each vertex
+
+vertex_t node (block b, size_t i = 1) {
+  return block_start[b] + i - 1;
+}
+
+// Output number to priority and owner, and whether the vertex was added.
+std::vector<std::pair<prio_t, int>> nodes;
+std::vector<bool> defined;
+csr_builder trans (0, 0);
 ssize_t nnodes = 0, ntrans = 0, highest_prio = 0;
 
-namespace std {
-  std::string operator+ (const std::string& s, size_t n) {
-    return s + std::to_string (n);
+void layout (size_t n) {
+  for (int b = 0; b < nblocks; ++b) {
+    bool single = b == C or b == S or b == R or b == X;
+    size_t size = single ? 1 : b == T or b == A ? 6*n-2 : n;
+    block_start[b + 1] = block_start[b] + size;
+    for (size_t i = 1; i <= size; ++i)
+      names.push_back (single ? block_name[b] : block_name[b] + std::to_string (i));
   }
+
+  size_t nv = names.size ();
+  std::vector<vertex_t> order (nv);
+  std::iota (order.begin (), order.end (), 0);
+  std::sort (order.begin (), order.end (), [] (auto a, auto b) { return names[a] < names[b]; });
+  rank.resize (nv);
+  for (size_t r = 0; r < nv; ++r)
+    rank[order[r]] = r;
+
+  nodes.resize (nv);
+  defined.resize (nv);
+  trans = csr_builder (nv, (7 * n * n + 75 * n) / 2);
 }
 
-void add_node (const std::string& name, int owner, prio_t prio) {
-  if (nodes.contains (name)) die ("node already exists " << name);
-  nodes[name] = { prio, owner };
+void add_node (vertex_t v, int owner, prio_t prio) {
+  if (defined[rank[v]]) die ("node already exists " << names[v]);
+  nodes[rank[v]] = { prio, owner };
+  defined[rank[v]] = true;
   ++nnodes;
   if (prio > highest_prio) highest_prio = prio;
 }
 
-void add_trans (const std::string& node, std::initializer_list<std::string> succs) {
-  if (not nodes.contains (node)) die ("adding transition from nonexisting node: " << node);
-  trans[node].insert (succs.begin (), succs.end ());
+void add_trans (vertex_t v, std::initializer_list<vertex_t> succs) {
+  if (not defined[rank[v]]) die ("adding transition from nonexisting node: " << names[v]);
+  for (auto s : succs)
+    trans.insert (rank[v], rank[s]);
   ntrans += succs.size ();
 }
 
@@ -52,82 +100,153 @@ void sanity_check (size_t n) {
     die ("wrong highest priority: " << highest_prio << " expected " << exp_high_prio);
 }
 
-auto rename_nodes () {
-  size_t sz = 0;
-  std::map<std::string, size_t> names;
-  for (auto&& [name, _] : nodes)
-    names[name] = sz++;
-  return names;
-}
-
-void dump_parity_game () {
-  std::cout << "parity " << nnodes << ";\n";
-
-  auto names = rename_nodes ();
-
-  for (auto&& [n, t] : nodes) {
-    std::cout << names[n] << " " << t.first << " " << t.second << " ";
+// Vertices are visited by increasing output number, and the successors in
+// the graph are sorted, as pgb_writer wants.  The sanity check ensures that
+// all the vertices, hence all the successors, were added.
+void dump_parity_game (const csr_graph& g, bool pgb) {
+  text_writer out (1);
+  pgb_writer bin (PGB_PARITY, false);
+  if (not pgb)
+    out << "parity " << nnodes << ";\n";
+
+  for (vertex_t v = 0; v < nnodes; ++v) {
+    auto [prio, owner] = nodes[v];
+    if (pgb) {
+      bin.vertex (owner);
+      bin.label (prio);
+    }
+    else
+      out << v << ' ' << prio << ' ' << owner << ' ';
     bool first = true;
-    for (auto&& succ : trans[n]) {
-      if (not names.contains (succ))
-        die ("successor of " << n << " undefined: " << succ);
-      if (not first) std::cout << ",";
+    for (auto succ : g.succ (v)) {
+      if (pgb) {
+        bin.edge (succ);
+        continue;
+      }
+      if (not first) out << ',';
       first = false;
-      std::cout << names[succ];
+      out << succ;
     }
-    std::cout << ";\n";
+    if (not pgb)
+      out << ";\n";
   }
+  if (pgb)
+    bin.write (out);
+  if (not out.close ())
+    die ("write error");
 }
 
-void dump_energy_game (bool perturbed) {
-  using mpz = boost::multiprecision::mpz_int;
-
-  std::cout << "energy " << nnodes << ";\n";
-
-  auto names = rename_nodes ();
-  auto highest_energy = mpz {pow (mpz {nnodes}, highest_prio)};
+// Vertex lines are formatted in parallel, in chunks of about chunk_bytes,
+// and the chunks are written in order.
+void dump_energy_game (const csr_graph& g, bool perturbed, bool pgb, bool sym, unsigned jobs) {
+  constexpr uint64_t chunk_bytes = 1 << 24;
 
-  std::vector<mpz> pot;
+  std::vector<uint64_t> prios;
+  for (auto&& [prio, owner] : nodes)
+    prios.push_back (prio);
+  power_table powers (-nnodes, prios);
+  std::vector<uint32_t> prio (nnodes); // Position in powers
+  for (vertex_t v = 0; v < nnodes; ++v)
+    prio[v] = powers.index (nodes[v].first);
 
+  std::optional<potential> pot;
   if (perturbed) {
-    boost::mt19937 rng (3); // fixing seed for repeatability
-    boost::uniform_int<mpz> gen (-highest_energy, +highest_energy);
-    pot.resize (nnodes);
-    for (ssize_t i = 0; i < nnodes; ++i)
-      pot[i] = gen (rng);
+    mpz_t highest_energy;
+    mpz_init (highest_energy);
+    mpz_abs (highest_energy, powers.largest ());
+    pot.emplace (nnodes, highest_energy, 3); // fixing seed for repeatability
+    mpz_clear (highest_energy);
   }
 
-  for (auto&& [n, t] : nodes) {
-    std::cout << names[n] << " " << t.second << " "; // owner only
+  text_writer out (1);
+  if (pgb) {
+    pgb_writer bin (PGB_ENERGY, true);
+    std::optional<potential::printer> print;
+    if (perturbed)
+      print.emplace (*pot);
+    for (vertex_t v = 0; v < nnodes; ++v) {
+      bin.vertex (nodes[v].second);
+      for (auto succ : g.succ (v)) {
+        bin.edge (succ);
+        bin.label (perturbed ? print->weight (powers.power (prio[v]), v, succ) : powers.power (prio[v]));
+      }
+    }
+    bin.write (out);
+    if (not out.close ())
+      die ("write error");
+    return;
+  }
 
-    mpz nrg_prio = pow (mpz {-nnodes}, t.first);
+  if (not sym)
+    parallel_for (powers.size (), jobs, [&] (size_t i) { powers.text (i); });
+  if (perturbed)
+    pot->decimals (jobs);
+
+  std::vector<vertex_t> cuts = { 0 };
+  uint64_t bytes = 0;
+  for (vertex_t v = 0; v < nnodes; ++v) {
+    bytes += g.succ (v).size () * (mpz_sizeinbase (powers.power (prio[v]), 10) + 8);
+    if (bytes >= chunk_bytes or v == nnodes - 1) {
+      cuts.push_back (v + 1);
+      bytes = 0;
+    }
+  }
 
-    bool first = true;
-    for (auto&& succ : trans[n]) {
-      if (not names.contains (succ))
-        die ("successor of " << n << " undefined: " << succ);
-      if (not first) std::cout << ",";
-      first = false;
+  // With sym, the weights are (-nnodes)^p(u) + (pot(v) - pot(u)), the latter
+  // being given by a printer from u with weight 0.
+  mpz_t zero;
+  mpz_init (zero);
+  out << (sym ? "energy-sym " : "energy ") << nnodes << ";\n";
+  turnstile turn;
+  parallel_for (cuts.size () - 1, jobs, [&] (size_t c) {
+    thread_local text_writer chunk; // Keeps its buffer from chunk to chunk
+    chunk.clear ();
+    std::optional<potential::printer> print;
+    if (perturbed)
+      print.emplace (*pot);
+    for (vertex_t v = cuts[c]; v < cuts[c + 1]; ++v) {
+      chunk << v << ' ' << nodes[v].second << ' '; // owner only
       if (perturbed)
-        std::cout << names[succ] << " " << nrg_prio + pot[names[succ]] - pot[names[n]];
-      else
-        std::cout << names[succ] << " " << nrg_prio;
+        print->from (v, sym ? zero : powers.power (prio[v]));
+      bool first = true;
+      for (auto succ : g.succ (v)) {
+        if (not first) chunk << ',';
+        first = false;
+        chunk << succ << ' ';
+        if (sym)
+          write_sym_weight (chunk, -nnodes, nodes[v].first, perturbed ? print->text (succ) : "");
+        else if (perturbed)
+          chunk << print->text (succ);
+        else
+          chunk << powers.text (prio[v]);
+      }
+      chunk << ";\n";
     }
-    std::cout << ";\n";
-  }
+    turn.wait (c);
+    out << chunk.text ();
+    turn.next ();
+  });
+  mpz_clear (zero);
+  if (not out.close ())
+    die ("write error");
 }
 
 void usage (char* prog) {
-  std::cerr << "usage: " << prog << " [-e|-p] N\n"
+  std::cerr << "usage: " << prog << " [-e|-p] [-j JOBS] [--format pg|pgb|sym] N\n"
             << "  -e: output an energy game with weights on edges.\n"
-            << "  -p: perturb the game by applying a random potential.\n";
+            << "  -p: perturb the game by applying a random potential.\n"
+            << "  -j: number of threads writing an energy game, 0 for one per core\n"
+            << "      (default: 0).\n"
+            << "  --format: PGSolver text (pg, the default), binary (pgb), or, with -e,\n"
+            << "      text with the weights as powers (sym, see energy-sym.hh).\n";
   exit (1);
 }
 
 int main (int argc, char** argv) {
   using namespace std::string_literals;
 
-  bool opt_energy = false, opt_perturbed = false;
+  bool opt_energy = false, opt_perturbed = false, opt_pgb = false, opt_sym = false;
+  unsigned opt_jobs = 0;
   char* prog = argv[0];
 
   while (true) {
@@ -143,120 +262,138 @@ int main (int argc, char** argv) {
       case 'p':
         opt_perturbed = true;
         break;
+      case 'j':
+        if (argc < 2)
+          usage (prog);
+        --argc, ++argv;
+        opt_jobs = std::stoul (argv[0]);
+        break;
+      case '-':
+        if (argv[0] != "--format"s or argc < 2)
+          usage (prog);
+        --argc, ++argv;
+        if (argv[0] != "pg"s and argv[0] != "pgb"s and argv[0] != "sym"s)
+          usage (prog);
+        opt_pgb = argv[0] == "pgb"s;
+        opt_sym = argv[0] == "sym"s;
+        break;
       default:
         usage (prog);
     }
   }
 
-  if (argc != 1) usage (prog);
+  if (argc != 1 or (opt_sym and not opt_energy)) usage (prog);
 
   size_t n = std::stoul (argv[0]);
+  layout (n);
 
   // ti
-  add_node ("t1", 0, 8*n+3);
-  add_trans ("t1", { "s", "r", "c" });
+  add_node (node (T, 1), 0, 8*n+3);
+  add_trans (node (T, 1), { node (S), node (R), node (C) });
   for (size_t i = 2; i <= 6*n-2; ++i) {
-    add_node ("t"s + i, 0, 8*n+2*i+1);
-    add_trans ("t"s + i, { "s", "r", "t"s + (i-1) });
+    add_node (node (T, i), 0, 8*n+2*i+1);
+    add_trans (node (T, i), { node (S), node (R), node (T, i-1) });
   }
 
   //ai
   for (size_t i = 1; i <= 6*n-2; ++i) {
-    add_node ("a"s + i, 1, 8*n + 2*i + 2);
-    add_trans ("a"s + i, { "t"s + i });
+    add_node (node (A, i), 1, 8*n + 2*i + 2);
+    add_trans (node (A, i), { node (T, i) });
   }
 
   // c
-  add_node ("c", 1, 20*n);
-  add_trans ("c", { "r" });
+  add_node (node (C), 1, 20*n);
+  add_trans (node (C), { node (R) });
 
   // d1_i
   for (size_t i = 1; i <= n; ++i) {
-    add_node ("d1_"s + i, 0, 8*i+1);
-    add_trans ("d1_"s + i, { "s", "c", "d2_"s + i });
+    add_node (node (D1, i), 0, 8*i+1);
+    add_trans (node (D1, i), { node (S), node (C), node (D2, i) });
     for (size_t j = 1; j <= 2*i-2; ++j) {
-      add_trans ("d1_"s + i, { "a"s + (3*j+3) });
+      add_trans (node (D1, i), { node (A, 3*j+3) });
     }
   }
 
   // d2_i
   for (size_t i = 1; i <= n; ++i) {
-    add_node ("d2_"s + i, 0, 8*i+3);
-    add_trans ("d2_"s + i, { "d3_"s + i });
+    add_node (node (D2, i), 0, 8*i+3);
+    add_trans (node (D2, i), { node (D3, i) });
     for (size_t j = 1; j <= 2*i-2; ++j) {
-      add_trans ("d2_"s + i, { "a"s + (3*j+2) });
+      add_trans (node (D2, i), { node (A, 3*j+2) });
     }
   }
 
   // d3_i
   for (size_t i = 1; i <= n; ++i) {
-    add_node ("d3_"s + i, 0, 8*i+5);
-    add_trans ("d3_"s + i, { "e"s + i });
+    add_node (node (D3, i), 0, 8*i+5);
+    add_trans (node (D3, i), { node (E, i) });
     for (size_t j = 1; j <= 2*i-1; ++j) {
-      add_trans ("d3_"s + i, { "a"s + (3*j+1) });
+      add_trans (node (D3, i), { node (A, 3*j+1) });
     }
   }
 
   // ei
   for (size_t i = 1; i <= n; ++i) {
-    add_node ("e"s + i, 1, 8*i+6);
-    add_trans ("e"s + i, { "d1_"s + i, "h"s + i });
+    add_node (node (E, i), 1, 8*i+6);
+    add_trans (node (E, i), { node (D1, i), node (H, i) });
   }
 
   // yi
   for (size_t i = 1; i <= n; ++i) {
-    add_node ("y"s + i, 0, 8*i+7);
-    add_trans ("y"s + i, { "f"s + i, "k"s + i });
+    add_node (node (Y, i), 0, 8*i+7);
+    add_trans (node (Y, i), { node (F, i), node (K, i) });
   }
 
   // gi
   for (size_t i = 1; i <= n; ++i) {
-    add_node ("g"s + i, 0, 8*i+8);
-    add_trans ("g"s + i, { "y"s + i, "k"s + i });
+    add_node (node (G, i), 0, 8*i+8);
+    add_trans (node (G, i), { node (Y, i), node (K, i) });
   }
 
   // ki
   for (size_t i = 1; i <= n; ++i) {
-    add_node ("k"s + i, 0, 20*n+4*i+3);
-    add_trans ("k"s + i, { "x" });
+    add_node (node (K, i), 0, 20*n+4*i+3);
+    add_trans (node (K, i), { node (X) });
     for (size_t j = i+1; j <= n; ++j) {
-      add_trans ("k"s + i, { "g"s + j });
+      add_trans (node (K, i), { node (G, j) });
     }
   }
 
   // fi
   for (size_t i = 1; i <= n; ++i) {
-    add_node ("f"s + i, 1, 20*n+4*i+5);
-    add_trans ("f"s + i, { "e"s + i });
+    add_node (node (F, i), 1, 20*n+4*i+5);
+    add_trans (node (F, i), { node (E, i) });
   }
 
   // fi
   for (size_t i = 1; i <= n; ++i) {
-    add_node ("h"s + i, 1, 20*n+4*i+6);
-    add_trans ("h"s + i, { "k"s + i });
+    add_node (node (H, i), 1, 20*n+4*i+6);
+    add_trans (node (H, i), { node (K, i) });
   }
 
   // s
-  add_node ("s", 0, 20*n+2);
-  add_trans ("s", { "x" });
+  add_node (node (S), 0, 20*n+2);
+  add_trans (node (S), { node (X) });
   for (size_t j = 1; j <= n; ++j) {
-    add_trans ("s", { "f"s + j });
+    add_trans (node (S), { node (F, j) });
   }
 
   // r
-  add_node ("r", 0, 20*n+4);
-  add_trans ("r", { "x" });
+  add_node (node (R), 0, 20*n+4);
+  add_trans (node (R), { node (X) });
   for (size_t j = 1; j <= n; ++j) {
-    add_trans ("r", { "g"s + j });
+    add_trans (node (R), { node (G, j) });
   }
 
   // x
-  add_node ("x", 1, 1);
-  add_trans ("x", { "x" });
+  add_node (node (X), 1, 1);
+  add_trans (node (X), { node (X) });
 
   sanity_check (n);
+  csr_graph g;
+  trans.build (g);
   if (opt_energy)
-    dump_energy_game (opt_perturbed);
+    dump_energy_game (g, opt_perturbed, opt_pgb, opt_sym, opt_jobs);
   else
-    dump_parity_game ();
+    dump_parity_game (g, opt_pgb);
 }
@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gmp.h>
+
+#include "content-hash.hh"
+#include "parallel.hh"
+#include "pg-parser.hh"
+#include "pgb.hh"
+
+#define die(S)                                  \
+  do {                                          \
+  std::cerr << S << "\n";                       \
+  exit (2);                                     \
+  } while (0)
+
+//////////////////// Duplicate games
+//
+// Files are first grouped by size, and only the files that share their size
+// with another are hashed, reading them in pieces.  Files with the same hash
+// are compared byte by byte before being reported as identical.
+//
+// With -c, every game is also parsed and hashed in a canonical form: the
+// kind, the number of vertices, the start vertex, then for each vertex its
+// owner, priority, and successors in increasing order with their weights.
+// This ignores vertex names, the header count, the order of the lines and of
+// the successors, and white space, but not a renumbering of the vertices.
+// Games with the same canonical hash are parsed again and their canonical
+// forms compared in full before being reported as equal.
+
+struct game {
+    std::string path;
+    uint64_t bytes;
+    uint64_t hash = 0, canonical = 0;
+    bool ok = true, parsed = false;
+};
+
+bool hash_file (game& g) {
+  int fd = open (g.path.c_str (), O_RDONLY);
+  if (fd < 0)
+    return false;
+  content_hash h;
+  std::vector<char> buf (1 << 20);
+  ssize_t r;
+  while ((r = read (fd, buf.data (), buf.size ())) > 0)
+    h.update ({ buf.data (), (size_t) r });
+  close (fd);
+  g.hash = h.digest ();
+  return r == 0;
+}
+
+bool same_bytes (const std::string& a, const std::string& b) {
+  mapped_file fa, fb;
+  return fa.open (a) and fb.open (b) and fa.text () == fb.text ();
+}
+
+// Canonical form, see above, as a stream of bytes given to a content_hash,
+// or kept to compare games.  Labels are written as 64-bit integers when they
+// fit, and as decimal text otherwise.
+template <typename Out>
+class canonical_form {
+  public:
+    void word (uint64_t w) { out.update ({ (const char*) &w, sizeof (w) }); }
+
+    void label (int64_t l) { word (0); word (l); }
+
+    void label (std::string_view l) {
+      word (1);
+      word (l.size ());
+      out.update (l);
+    }
+
+    Out out;
+};
+
+struct byte_string : std::string {
+    void update (std::string_view s) { append (s); }
+};
+
+// Writes the canonical form of the game at path to h.
+template <typename Form>
+bool canonical (const std::string& path, Form& h, std::string& err) {
+  std::vector<uint64_t> order;
+  auto sort_succ = [&] (auto targets, uint64_t first, uint64_t last) {
+    order.resize (last - first);
+    std::iota (order.begin (), order.end (), first);
+    std::stable_sort (order.begin (), order.end (),
+                      [&] (auto a, auto b) { return targets[a] < targets[b]; });
+  };
+
+  if (path.ends_with (".pgb")) {
+    pgb_game p;
+    if (not p.open (path)) {
+      err = p.error ();
+      return false;
+    }
+    h.word (p.energy ());
+    h.word (p.nvertices ());
+    h.word (p.header ().start);
+    mpz_t z;
+    std::vector<char> s;
+    auto label = [&] (uint64_t i) {
+      if (not p.bignum ())
+        return h.label (p.label (i));
+      auto l = p.label_mpz (i, z);
+      if (mpz_fits_slong_p (l))
+        return h.label (mpz_get_si (l));
+      s.resize (mpz_sizeinbase (l, 10) + 2);
+      h.label (std::string_view (mpz_get_str (s.data (), 10, l)));
+    };
+    for (uint64_t v = 0; v < p.nvertices (); ++v) {
+      h.word (p.owner (v));
+      if (not p.energy ())
+        label (v);
+      // Successors of .pgb files are sorted already.
+      h.word (p.succ (v).size ());
+      for (uint64_t e = p.first_edge (v); e < p.first_edge (v + 1); ++e) {
+        h.word (p.succ (v)[e - p.first_edge (v)]);
+        if (p.energy ())
+          label (e);
+      }
+    }
+    return true;
+  }
+
+  mapped_file file;
+  pg_game p;
+  if (not file.open (path)) {
+    err = "cannot open file";
+    return false;
+  }
+  if (not parse_pg (file.text (), p, err))
+    return false;
+  h.word (p.energy);
+  h.word (p.nvertices ());
+  h.word (p.start);
+  auto label = [&] (uint64_t i) {
+    auto big = std::lower_bound (p.big_labels.begin (), p.big_labels.end (), i,
+                                 [] (auto& b, uint64_t i) { return b.first < i; });
+    if (big != p.big_labels.end () and big->first == i)
+      h.label (big->second);
+    else
+      h.label (p.labels[i]);
+  };
+  for (uint64_t v = 0; v < p.nvertices (); ++v) {
+    h.word (p.owners[v]);
+    if (not p.energy)
+      label (v);
+    sort_succ (p.graph.targets.data (), p.graph.offsets[v], p.graph.offsets[v + 1]);
+    h.word (order.size ());
+    for (auto e : order) {
+      h.word (p.graph.targets[e]);
+      if (p.energy)
+        label (e);
+    }
+  }
+  return true;
+}
+
+bool hash_canonical (game& g, std::string& err) {
+  canonical_form<content_hash> h;
+  if (not canonical (g.path, h, err))
+    return false;
+  g.canonical = h.out.digest ();
+  return true;
+}
+
+// Whether two games that parsed have the same canonical form.
+bool same_canonical (const std::string& a, const std::string& b) {
+  canonical_form<byte_string> fa, fb;
+  std::string err;
+  return canonical (a, fa, err) and canonical (b, fb, err) and fa.out == fb.out;
+}
+
+void usage (char* prog) {
+  std::cerr << "usage: " << prog << " [-c] [-j JOBS] [-l RUN-LIST] DIR-OR-GAME...\n"
+            << "  Report the clusters of duplicate games (.pg and .pgb files) found under\n"
+            << "  the arguments.\n"
+            << "  -c: also find games that are equal once parsed (see game-dedup.cc).\n"
+            << "  -j: number of files read in parallel, 0 for one per core (default: 0).\n"
+            << "  -l: write the list of games with one representative per cluster.\n";
+  exit (1);
+}
+
+int main (int argc, char** argv) {
+  namespace fs = std::filesystem;
+  char* prog = argv[0];
+  bool canonical = false;
+  unsigned jobs = 0;
+  std::string run_list;
+  std::vector<std::string> roots;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "-c")
+      canonical = true;
+    else if (a == "-j" and i + 1 < argc)
+      jobs = std::stoul (argv[++i]);
+    else if (a == "-l" and i + 1 < argc)
+      run_list = argv[++i];
+    else if (a.starts_with ("-"))
+      usage (prog);
+    else
+      roots.push_back (a);
+  }
+  if (roots.empty ()) usage (prog);
+
+  std::vector<game> games;
+  auto add = [&] (const fs::path& p) {
+    auto ext = p.extension ();
+    struct stat st;
+    if ((ext == ".pg" or ext == ".pgb") and stat (p.c_str (), &st) == 0)
+      games.push_back ({ p.string (), (uint64_t) st.st_size });
+  };
+  for (auto&& r : roots) {
+    std::error_code ec;
+    if (fs::is_directory (r, ec)) {
+      for (auto&& d : fs::recursive_directory_iterator (r, ec))
+        if (d.is_regular_file ())
+          add (d.path ());
+    }
+    else
+      add (r);
+    if (ec) die (r << ": " << ec.message ());
+  }
+  std::sort (games.begin (), games.end (), [] (auto& a, auto& b) { return a.path < b.path; });
+
+  // Files to read: the ones sharing their size with another, or all of them
+  // with -c; largest first.
+  std::map<uint64_t, size_t> same_size;
+  for (auto&& g : games)
+    ++same_size[g.bytes];
+  std::vector<game*> todo;
+  for (auto&& g : games)
+    if (canonical or same_size[g.bytes] > 1)
+      todo.push_back (&g);
+  std::sort (todo.begin (), todo.end (), [] (auto a, auto b) { return a->bytes > b->bytes; });
+
+  std::mutex err_mtx;
+  parallel_for (todo.size (), jobs, [&] (size_t i) {
+    auto& g = *todo[i];
+    std::string err;
+    g.ok = same_size.at (g.bytes) == 1 or hash_file (g);
+    if (g.ok and canonical)
+      g.parsed = hash_canonical (g, err);
+    std::lock_guard lock (err_mtx);
+    if (not g.ok)
+      std::cerr << g.path << ": cannot read file, skipped\n";
+    else if (canonical and not g.parsed)
+      std::cerr << g.path << ": " << err << ", only compared byte by byte\n";
+  });
+
+  // Clusters: identical bytes first, then, with -c, identical canonical
+  // forms.  rep[i] is the first game of the cluster of game i.
+  std::vector<size_t> rep (games.size ());
+  std::iota (rep.begin (), rep.end (), 0);
+  std::map<std::pair<uint64_t, uint64_t>, std::vector<size_t>> by_hash;
+  for (size_t i = 0; i < games.size (); ++i)
+    if (games[i].ok and same_size[games[i].bytes] > 1)
+      by_hash[{ games[i].bytes, games[i].hash }].push_back (i);
+  for (auto&& [_, members] : by_hash)
+    for (size_t a = 0; a < members.size (); ++a)
+      for (size_t b = 0; b < a and rep[members[a]] == members[a]; ++b)
+        if (rep[members[b]] == members[b] and same_bytes (games[members[a]].path, games[members[b]].path))
+          rep[members[a]] = members[b];
+
+  auto byte_rep = rep;
+  if (canonical) {
+    // Representatives of the clusters so far, by canonical hash.
+    std::map<uint64_t, std::vector<size_t>> reps;
+    for (size_t i = 0; i < games.size (); ++i)
+      if (games[i].parsed and rep[i] == i) {
+        auto& candidates = reps[games[i].canonical];
+        for (auto r : candidates)
+          if (same_canonical (games[r].path, games[i].path)) {
+            rep[i] = r;
+            break;
+          }
+        if (rep[i] == i)
+          candidates.push_back (i);
+      }
+    for (size_t i = 0; i < games.size (); ++i)
+      rep[i] = rep[rep[i]];
+  }
+
+  std::map<size_t, std::vector<size_t>> clusters;
+  for (size_t i = 0; i < games.size (); ++i)
+    if (rep[i] != i)
+      clusters[rep[i]].push_back (i);
+
+  uint64_t saved = 0;
+  for (auto&& [r, dups] : clusters) {
+    auto bytewise = [&] (size_t d) { return byte_rep[d] == r; };
+    bool all_bytes = std::all_of (dups.begin (), dups.end (), bytewise);
+    std::cout << "# " << dups.size () + 1 << " games, "
+              << (all_bytes ? "identical bytes" : "same canonical game") << "\n"
+              << games[r].path << "\n";
+    for (auto d : dups) {
+      std::cout << games[d].path << (bytewise (d) ? "" : " (canonical)") << "\n";
+      saved += games[d].bytes;
+    }
+  }
+  std::cerr << games.size () << " games, " << clusters.size () << " clusters of duplicates, "
+            << saved << " duplicate bytes\n";
+
+  if (not run_list.empty ()) {
+    std::ofstream out (run_list);
+    for (size_t i = 0; i < games.size (); ++i)
+      if (games[i].ok and rep[i] == i)
+        out << games[i].path << "\n";
+    if (not out.flush ()) die (run_list << ": write error");
+  }
+}
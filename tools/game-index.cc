@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <bit>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include <gmp.h>
+
+#include "content-hash.hh"
+#include "parallel.hh"
+#include "pg-parser.hh"
+#include "pgb.hh"
+
+#define die(S)                                  \
+  do {                                          \
+  std::cerr << S << "\n";                       \
+  exit (2);                                     \
+  } while (0)
+
+//////////////////// Game index
+//
+// The index is a tab-separated file with one line per game, sorted by path,
+// after a header line starting with '#'.  The columns are listed in COLUMNS.
+// For energy games, the labels counted as priorities are the edge weights.
+// max_priority is the largest label, in decimal, or "-" for a game without
+// labels; label_bits is the bit size of the largest absolute value of a
+// label.
+// Games whose size and modification time did not change since the previous
+// index are not read again.
+
+const char* COLUMNS = "#path\tbytes\tmtime\thash\tkind\tvertices\tedges\tpriorities\t"
+                      "max_priority\tlabel_bits\towner0\towner1\tself_loops";
+
+struct entry {
+    std::string path;
+    uint64_t bytes = 0, mtime = 0;
+    std::string fields; // Columns after mtime
+    bool ok = true;
+};
+
+// Accumulates the statistics of a game.  Labels that do not fit in an
+// int64_t are only kept as views into the mapped file, as the weights of a
+// dense game can take gigabytes: their decimal text in a .pg file, or their
+// pool entry in a .pgb file.  Only the largest ones are converted.
+class game_stats {
+  public:
+    void label (int64_t l) { small.push_back (l); }
+
+    // A label in decimal, without leading zeros.
+    void label (std::string_view l) {
+      auto abs = [] (std::string_view a) { return a.substr (a.starts_with ('-')); };
+      auto larger_abs = [&] (std::string_view a, std::string_view b) {
+        a = abs (a), b = abs (b);
+        return a.size () != b.size () ? a.size () > b.size () : a > b;
+      };
+      if (big.empty () or larger_abs (l, max_abs_text))
+        max_abs_text = l;
+      bool neg = l[0] == '-', max_neg = max_text.starts_with ('-');
+      if (big.empty () or (neg != max_neg ? max_neg : larger_abs (l, max_text) != neg))
+        max_text = l;
+      big.push_back (l);
+    }
+
+    // A label read from a .pgb pool, whose entry is bytes.
+    void label (mpz_srcptr z, std::string_view bytes) {
+      big_bits = std::max<uint64_t> (big_bits, mpz_sizeinbase (z, 2));
+      if (big.empty () or mpz_cmp (z, &max_mpz) > 0)
+        max_mpz = *z; // Points into the file
+      big.push_back (bytes);
+    }
+
+    std::string fields (const std::string& hash, bool energy, uint64_t nvertices,
+                        uint64_t nedges, uint64_t owner0, uint64_t self_loops) {
+      std::sort (small.begin (), small.end ());
+      uint64_t distinct = std::unique (small.begin (), small.end ()) - small.begin ();
+      std::string max = distinct ? std::to_string (small[distinct - 1]) : "-";
+      uint64_t bits = 0;
+      if (distinct)
+        for (auto l : { small[0], small[distinct - 1] })
+          bits = std::max<uint64_t> (bits, std::bit_width (l < 0 ? -(uint64_t) l : (uint64_t) l));
+
+      // A label that does not fit is larger than all the others if positive,
+      // and smaller if negative.
+      bool big_max = not big.empty () and (distinct == 0 or
+                                            (max_text.empty () ? mpz_sgn (&max_mpz) > 0 : max_text[0] != '-'));
+      std::sort (big.begin (), big.end ());
+      distinct += std::unique (big.begin (), big.end ()) - big.begin ();
+      if (not max_abs_text.empty ()) {
+        mpz_t z;
+        mpz_init_set_str (z, std::string (max_abs_text).c_str (), 10);
+        big_bits = std::max<uint64_t> (big_bits, mpz_sizeinbase (z, 2));
+        mpz_clear (z);
+      }
+      bits = std::max (bits, big_bits);
+      if (big_max and not max_text.empty ())
+        max = max_text;
+      else if (big_max) {
+        std::vector<char> s (mpz_sizeinbase (&max_mpz, 10) + 2);
+        max = mpz_get_str (s.data (), 10, &max_mpz);
+      }
+
+      std::ostringstream os;
+      os << hash << '\t' << (energy ? "energy" : "parity") << '\t' << nvertices << '\t' << nedges
+         << '\t' << distinct << '\t' << max << '\t' << bits << '\t' << owner0
+         << '\t' << nvertices - owner0 << '\t' << self_loops;
+      return os.str ();
+    }
+
+  private:
+    std::vector<int64_t> small;
+    std::vector<std::string_view> big;
+    std::string_view max_abs_text, max_text; // Largest absolute value, and largest, in decimal
+    __mpz_struct max_mpz {};                  // Largest, from a .pgb file
+    uint64_t big_bits = 0;
+};
+
+bool index_game (entry& e, std::string& err) {
+  mapped_file file;
+  if (not file.open (e.path)) {
+    err = "cannot open file";
+    return false;
+  }
+  content_hash h;
+  h.update (file.text ());
+  auto hash = content_hash::hex (h.digest ());
+  game_stats stats;
+  uint64_t owner0 = 0, self_loops = 0;
+
+  if (e.path.ends_with (".pgb")) {
+    pgb_game g;
+    if (not g.open (e.path)) {
+      err = g.error ();
+      return false;
+    }
+    mpz_t z;
+    for (uint64_t i = 0; i < (g.energy () ? g.nedges () : g.nvertices ()); ++i)
+      if (not g.bignum ())
+        stats.label (g.label (i));
+      else {
+        auto l = g.label_mpz (i, z);
+        if (mpz_fits_slong_p (l))
+          stats.label (mpz_get_si (l));
+        else
+          stats.label (l, g.label_bytes (i));
+      }
+    for (uint64_t v = 0; v < g.nvertices (); ++v) {
+      owner0 += g.owner (v) == 0;
+      for (auto t : g.succ (v))
+        self_loops += t == v;
+    }
+    e.fields = stats.fields (hash, g.energy (), g.nvertices (), g.nedges (), owner0, self_loops);
+    return true;
+  }
+
+  pg_game g;
+  if (not parse_pg (file.text (), g, err))
+    return false;
+  auto big = g.big_labels.begin ();
+  for (uint64_t i = 0; i < g.labels.size (); ++i)
+    if (big != g.big_labels.end () and big->first == i)
+      stats.label ((big++)->second);
+    else
+      stats.label (g.labels[i]);
+  for (uint64_t v = 0; v < g.nvertices (); ++v) {
+    owner0 += g.owners[v] == 0;
+    for (auto t : g.graph.succ (v))
+      self_loops += t == v;
+  }
+  e.fields = stats.fields (hash, g.energy, g.nvertices (), g.nedges (), owner0, self_loops);
+  return true;
+}
+
+void usage (char* prog) {
+  std::cerr << "usage: " << prog << " [-o INDEX] [-j JOBS] DIR-OR-GAME...\n"
+            << "  Index the games (.pg and .pgb files) found under the arguments; the\n"
+            << "  index lists exactly these games.\n"
+            << "  -o: index file, updated in place (default: game-index.tsv).\n"
+            << "  -j: number of games read in parallel, 0 for one per core (default: 0).\n";
+  exit (1);
+}
+
+int main (int argc, char** argv) {
+  namespace fs = std::filesystem;
+  char* prog = argv[0];
+  std::string index_path = "game-index.tsv";
+  unsigned jobs = 0;
+  std::vector<std::string> roots;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "-o" and i + 1 < argc)
+      index_path = argv[++i];
+    else if (a == "-j" and i + 1 < argc)
+      jobs = std::stoul (argv[++i]);
+    else if (a.starts_with ("-"))
+      usage (prog);
+    else
+      roots.push_back (a);
+  }
+  if (roots.empty ()) usage (prog);
+
+  // Previous index, if it has the same columns
+  std::map<std::string, entry> old;
+  {
+    std::ifstream in (index_path);
+    std::string line;
+    if (std::getline (in, line) and line != COLUMNS)
+      in.setstate (std::ios::failbit);
+    while (std::getline (in, line)) {
+      entry e;
+      std::istringstream is (line);
+      std::getline (is, e.path, '\t');
+      is >> e.bytes >> e.mtime;
+      is.ignore (1);
+      std::getline (is, e.fields);
+      old[e.path] = e;
+    }
+  }
+
+  // Current games
+  std::vector<entry> games;
+  auto add = [&] (const fs::path& p) {
+    auto ext = p.extension ();
+    if (ext != ".pg" and ext != ".pgb")
+      return;
+    struct stat st;
+    if (stat (p.c_str (), &st) != 0)
+      return;
+    entry e;
+    e.path = p.string ();
+    e.bytes = st.st_size;
+    e.mtime = st.st_mtim.tv_sec * 1000000000ull + st.st_mtim.tv_nsec;
+    games.push_back (e);
+  };
+  for (auto&& r : roots) {
+    std::error_code ec;
+    if (fs::is_directory (r, ec)) {
+      for (auto&& d : fs::recursive_directory_iterator (r, ec))
+        if (d.is_regular_file ())
+          add (d.path ());
+    }
+    else
+      add (r);
+    if (ec) die (r << ": " << ec.message ());
+  }
+
+  // Read the new and changed games, largest first so that the last ones to
+  // finish are small.
+  std::vector<entry*> todo;
+  for (auto&& e : games) {
+    auto o = old.find (e.path);
+    if (o != old.end () and o->second.bytes == e.bytes and o->second.mtime == e.mtime)
+      e.fields = o->second.fields;
+    else
+      todo.push_back (&e);
+  }
+  std::sort (todo.begin (), todo.end (), [] (auto a, auto b) { return a->bytes > b->bytes; });
+
+  std::mutex progress_mtx;
+  size_t done = 0;
+  parallel_for (todo.size (), jobs, [&] (size_t i) {
+    std::string err;
+    todo[i]->ok = index_game (*todo[i], err);
+    std::lock_guard lock (progress_mtx);
+    if (not todo[i]->ok)
+      std::cerr << todo[i]->path << ": " << err << ", skipped\n";
+    if (++done % 100 == 0)
+      std::cerr << "\rgame " << done << "/" << todo.size () << "... ";
+  });
+
+  std::sort (games.begin (), games.end (), [] (auto& a, auto& b) { return a.path < b.path; });
+  auto tmp = index_path + ".tmp";
+  {
+    std::ofstream out (tmp);
+    out << COLUMNS << "\n";
+    for (auto&& e : games)
+      if (e.ok)
+        out << e.path << '\t' << e.bytes << '\t' << e.mtime << '\t' << e.fields << "\n";
+    if (not out.flush ()) die (tmp << ": write error");
+  }
+  if (std::rename (tmp.c_str (), index_path.c_str ()) != 0)
+    die (index_path << ": cannot replace the index");
+  std::cerr << games.size () << " games, " << todo.size () << " read\n";
+}
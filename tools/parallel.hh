@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//////////////////// Minimal thread pool helpers
+
+// Call f (i) for every i in [0, n) using `jobs` threads (the calling thread
+// being one of them).  Indices are handed out in increasing order, one at a
+// time, so that long-running items do not hold back the others.
+template <typename F>
+void parallel_for (size_t n, unsigned jobs, F&& f) {
+  std::atomic<size_t> next = 0;
+  auto worker = [&] () {
+    for (size_t i; (i = next++) < n; )
+      f (i);
+  };
+
+  if (jobs == 0) jobs = std::thread::hardware_concurrency ();
+  if (jobs > n) jobs = n;
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 1; t < jobs; ++t)
+    threads.emplace_back (worker);
+  worker ();
+  for (auto&& t : threads)
+    t.join ();
+}
+
+// Lets the workers of a parallel_for take turns in increasing index order,
+// e.g., to write results to a shared stream.
+class turnstile {
+  public:
+    void wait (size_t i) {
+      std::unique_lock lock (mtx);
+      cv.wait (lock, [&] { return current == i; });
+    }
+
+    void next () {
+      {
+        std::lock_guard lock (mtx);
+        ++current;
+      }
+      cv.notify_all ();
+    }
+
+  private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t current = 0;
+};
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "csr-graph.hh"
+#include "pg-parser.hh"
+#include "pgb.hh"
+#include "text-writer.hh"
+
+#define die(S)                                  \
+  do {                                          \
+  std::cerr << S << "\n";                       \
+  exit (2);                                     \
+  } while (0)
+
+//////////////////// Priority compression
+//
+// The winner of a play only depends on the largest priority seen infinitely
+// often, and the vertices seen infinitely often all lie in one strongly
+// connected component.  Hence the priorities of each component can be
+// renumbered independently, as long as their order and parity are kept:
+// going up through the distinct priorities of the component, the new
+// priority only grows, by one, when the parity changes, so that priorities of
+// the same parity with none of the other parity in between are merged.  The
+// first priority of a component is 0 or 1, depending on its parity.
+// Vertices on no cycle are never seen infinitely often and get priority 0.
+//
+// With --global, the whole game is compressed as a single component.
+//
+// This takes O (E + V log V): Tarjan's algorithm, then one sort of the
+// vertices by component and priority.
+
+void usage (char* prog) {
+  std::cerr << "usage: " << prog << " [--global] [--format pg|pgb] GAME.pg [OUTPUT]\n"
+            << "  Compress the priorities of a parity game; see pg-compress-priorities.cc.\n"
+            << "  The output (default: stdout) is in PGSolver text (pg, the default) or\n"
+            << "  binary (pgb).  Vertex names are not kept.\n";
+  exit (1);
+}
+
+int main (int argc, char** argv) {
+  char* prog = argv[0];
+  bool global = false, pgb = false;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--global")
+      global = true;
+    else if (a == "--format" and i + 1 < argc) {
+      std::string f = argv[++i];
+      if (f != "pg" and f != "pgb") usage (prog);
+      pgb = f == "pgb";
+    }
+    else if (a.starts_with ("-"))
+      usage (prog);
+    else
+      files.push_back (a);
+  }
+  if (files.empty () or files.size () > 2) usage (prog);
+
+  mapped_file text;
+  if (not text.open (files[0])) die (files[0] << ": cannot open file");
+  pg_game g;
+  std::string err;
+  if (not parse_pg (text.text (), g, err, 0)) die (files[0] << ": " << err);
+  if (g.energy) die (files[0] << ": not a parity game");
+  if (g.nvertices () == 0) die (files[0] << ": empty game");
+  if (not g.big_labels.empty () or std::any_of (g.labels.begin (), g.labels.end (), [] (auto p) { return p < 0; }))
+    die (files[0] << ": priorities should be natural numbers");
+
+  size_t n = g.nvertices ();
+  std::vector<vertex_t> comp;
+  if (global)
+    comp.assign (n, 0);
+  else
+    scc_decomposition (g.graph, comp);
+
+  // A vertex is on a cycle if its component has another vertex, or if it
+  // has a self-loop.
+  std::vector<uint64_t> comp_size (n);
+  for (auto c : comp)
+    ++comp_size[c];
+  auto on_cycle = [&] (vertex_t v) {
+    if (global or comp_size[comp[v]] > 1)
+      return true;
+    auto s = g.graph.succ (v);
+    return std::find (s.begin (), s.end (), v) != s.end ();
+  };
+
+  std::vector<std::tuple<vertex_t, int64_t, vertex_t>> order; // component, priority, vertex
+  std::vector<int64_t> prio (n, 0);
+  order.reserve (n);
+  for (vertex_t v = 0; v < n; ++v)
+    if (on_cycle (v))
+      order.push_back ({ comp[v], g.labels[v], v });
+  std::sort (order.begin (), order.end ());
+
+  for (size_t i = 0; i < order.size (); ++i) {
+    auto [c, p, v] = order[i];
+    if (i == 0 or std::get<0> (order[i - 1]) != c)
+      prio[v] = p % 2;
+    else {
+      auto [pc, pp, pv] = order[i - 1];
+      prio[v] = prio[pv] + (p % 2 != pp % 2);
+    }
+  }
+
+  auto distinct = [] (std::vector<int64_t> v) {
+    std::sort (v.begin (), v.end ());
+    return std::unique (v.begin (), v.end ()) - v.begin ();
+  };
+  std::cerr << files[0] << ": " << distinct (g.labels) << " priorities, max "
+            << *std::max_element (g.labels.begin (), g.labels.end ()) << " -> "
+            << distinct (prio) << " priorities, max " << *std::max_element (prio.begin (), prio.end ())
+            << "\n";
+
+  text_writer out = files.size () == 2 ? text_writer (files[1]) : text_writer (1);
+  if (not out.good ()) die (files[1] << ": cannot open file for writing");
+  if (pgb) {
+    pgb_writer bin (PGB_PARITY, false);
+    if (g.start != PG_NO_START)
+      bin.start (g.start);
+    std::vector<vertex_t> succ;
+    for (vertex_t v = 0; v < n; ++v) {
+      bin.vertex (g.owners[v]);
+      bin.label (prio[v]);
+      auto s = g.graph.succ (v);
+      succ.assign (s.begin (), s.end ());
+      std::sort (succ.begin (), succ.end ());
+      for (auto t : succ)
+        bin.edge (t);
+    }
+    bin.write (out);
+  }
+  else {
+    out << "parity " << n << ";\n";
+    if (g.start != PG_NO_START)
+      out << "start " << g.start << ";\n";
+    for (vertex_t v = 0; v < n; ++v) {
+      out << v << ' ' << prio[v] << ' ' << (int) g.owners[v] << ' ';
+      bool first = true;
+      for (auto t : g.graph.succ (v)) {
+        if (not first) out << ',';
+        out << t;
+        first = false;
+      }
+      out << ";\n";
+    }
+  }
+  if (not out.close ())
+    die ((files.size () == 2 ? files[1] : "stdout") << ": write error");
+}
@@ -0,0 +1,550 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined (__AVX2__) || defined (__SSE2__)
+# include <immintrin.h>
+#endif
+
+#include "csr-graph.hh"
+#include "parallel.hh"
+
+//////////////////// PGSolver text parser
+//
+// Reads the games of the corpus:
+//     parity N;
+//     [start S;]
+//     id priority owner succ,succ,... ["name"];
+// and the energy games written by the generators of this repository:
+//     energy N;
+//     id owner succ weight,succ weight,... ["name"];
+// The header count is ignored, as some tools write the largest vertex number
+// there; vertices must be numbered 0 to n - 1, in any order.  A vertex line
+// may have no successors.
+//
+// The file is mapped in memory and scanned 64 bytes at a time: SIMD compares
+// turn each block into bitmasks of digits, semicolons, quotes and unexpected
+// characters, quoted names are masked out with a prefix xor, and the parser
+// only visits the starts of numbers and the ends of lines.  Labels that do
+// not fit in an int64_t are kept as text, pointing into the mapping.
+//
+// Large files are cut after ";\n" into chunks of at least pg_min_chunk bytes,
+// one per job, which are parsed in parallel; the parts of the game read from
+// each chunk are then copied in place at offsets given by prefix sums.  (A
+// vertex name containing ";\n" would break this.)
+
+class mapped_file {
+  public:
+    mapped_file () = default;
+    mapped_file (const mapped_file&) = delete;
+
+    ~mapped_file () {
+      if (data_)
+        munmap ((void*) data_, size_);
+    }
+
+    bool open (const std::string& path) {
+      int fd = ::open (path.c_str (), O_RDONLY);
+      if (fd < 0)
+        return false;
+      struct stat st;
+      bool ok = fstat (fd, &st) == 0;
+      size_ = ok ? st.st_size : 0;
+      if (ok and size_) {
+        void* p = mmap (nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ok = p != MAP_FAILED;
+        if (ok) {
+          madvise (p, size_, MADV_SEQUENTIAL);
+          data_ = (const char*) p;
+        }
+      }
+      ::close (fd);
+      return ok;
+    }
+
+    std::string_view text () const { return { data_, size_ }; }
+
+  private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+constexpr uint64_t PG_NO_START = ~uint64_t {0};
+constexpr size_t pg_min_chunk = 1 << 20;
+
+struct pg_game {
+    bool energy = false;
+    uint64_t start = PG_NO_START;
+    std::vector<uint8_t> owners;
+    csr_graph graph;               // successors in file order
+    // Priorities by vertex, or weights by edge.  The ones that do not fit are
+    // 0 here and listed in big_labels, sorted by index.
+    std::vector<int64_t> labels;
+    std::vector<std::pair<uint64_t, std::string_view>> big_labels;
+
+    size_t nvertices () const { return owners.size (); }
+    size_t nedges () const { return graph.nedges (); }
+};
+
+namespace pg_detail {
+  // Bitmasks of one 64-byte block, bit i for byte i.
+  struct block {
+      uint64_t num;    // digits and minus signs
+      uint64_t semi;
+      uint64_t quote;
+      uint64_t other;  // not a number, separator, or quote
+  };
+
+  inline block classify (const char* s) {
+    block b {};
+#if defined (__AVX2__)
+    for (int h = 0; h < 2; ++h) {
+      __m256i v = _mm256_loadu_si256 ((const __m256i*) (s + 32 * h));
+      auto eq = [&] (char c) -> uint64_t {
+        return (uint32_t) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (v, _mm256_set1_epi8 (c)));
+      };
+      __m256i d = _mm256_sub_epi8 (v, _mm256_set1_epi8 ('0'));
+      uint64_t digit = (uint32_t) _mm256_movemask_epi8 (
+        _mm256_cmpeq_epi8 (_mm256_min_epu8 (d, _mm256_set1_epi8 (9)), d));
+      uint64_t num = digit | eq ('-'), semi = eq (';'), quote = eq ('"');
+      uint64_t sep = eq (' ') | eq ('\n') | eq (',') | eq ('\t') | eq ('\r');
+      b.num |= num << (32 * h);
+      b.semi |= semi << (32 * h);
+      b.quote |= quote << (32 * h);
+      b.other |= (~(num | semi | quote | sep) & 0xffffffff) << (32 * h);
+    }
+#elif defined (__SSE2__)
+    for (int h = 0; h < 4; ++h) {
+      __m128i v = _mm_loadu_si128 ((const __m128i*) (s + 16 * h));
+      auto eq = [&] (char c) -> uint64_t {
+        return (uint16_t) _mm_movemask_epi8 (_mm_cmpeq_epi8 (v, _mm_set1_epi8 (c)));
+      };
+      __m128i d = _mm_sub_epi8 (v, _mm_set1_epi8 ('0'));
+      uint64_t digit = (uint16_t) _mm_movemask_epi8 (
+        _mm_cmpeq_epi8 (_mm_min_epu8 (d, _mm_set1_epi8 (9)), d));
+      uint64_t num = digit | eq ('-'), semi = eq (';'), quote = eq ('"');
+      uint64_t sep = eq (' ') | eq ('\n') | eq (',') | eq ('\t') | eq ('\r');
+      b.num |= num << (16 * h);
+      b.semi |= semi << (16 * h);
+      b.quote |= quote << (16 * h);
+      b.other |= (~(num | semi | quote | sep) & 0xffff) << (16 * h);
+    }
+#else
+    for (int i = 0; i < 64; ++i) {
+      uint64_t bit = uint64_t {1} << i;
+      switch (s[i]) {
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9': case '-':
+          b.num |= bit; break;
+        case ';': b.semi |= bit; break;
+        case '"': b.quote |= bit; break;
+        case ' ': case '\n': case ',': case '\t': case '\r': break;
+        default: b.other |= bit;
+      }
+    }
+#endif
+    return b;
+  }
+
+  // Bit i of the result is the xor of bits 0 to i of x.
+  inline uint64_t prefix_xor (uint64_t x) {
+    for (int s = 1; s < 64; s *= 2)
+      x ^= x << s;
+    return x;
+  }
+
+  // Whether the first len <= 8 bytes at s, where 8 bytes can be read, are
+  // all digits.  They are digits or minus signs, hence ASCII: a byte is not a
+  // digit if subtracting '0' borrows or adding 0x7f - '9' carries into its
+  // top bit.  A borrow only spreads to the following bytes, and only from a
+  // byte that is flagged itself.
+  inline bool all_digits (const char* s, int len) {
+    uint64_t v;
+    std::memcpy (&v, s, 8);
+    uint64_t bad = ((v - 0x3030303030303030) | (v + 0x4646464646464646)) & 0x8080808080808080;
+    return (bad & (~uint64_t {0} >> (8 * (8 - len)))) == 0;
+  }
+
+  // Value of the len <= 8 digits at s, where 8 bytes can be read: the digits
+  // are moved to the top of a word, below leading zeros, and combined by
+  // pairs, then fours, then eights.
+  inline uint64_t parse_eight (const char* s, int len) {
+    uint64_t v;
+    std::memcpy (&v, s, 8);
+    v = (v - 0x3030303030303030) << (8 * (8 - len));
+    v = (v & 0x0f0f0f0f0f0f0f0f) * 2561 >> 8;
+    v = (v & 0x00ff00ff00ff00ff) * 6553601 >> 16;
+    return (v & 0x0000ffff0000ffff) * 42949672960001 >> 32;
+  }
+
+  // Parsed lines of a part of a file, in file order.
+  struct fragment {
+      std::vector<uint64_t> ids, first_edge;
+      std::vector<uint8_t> owners;
+      std::vector<int64_t> vertex_labels, edge_labels;
+      std::vector<vertex_t> targets;
+      std::vector<std::pair<uint64_t, std::string_view>> big_vertex_labels, big_edge_labels;
+      uint64_t start = PG_NO_START;
+      const char* error_at = nullptr;
+      const char* error = nullptr;
+  };
+
+  // Parses the vertex and start lines in [p, end) into f.  Returns false on
+  // error, with f.error_at and f.error set.
+  inline bool parse_lines (const char* p, const char* end, bool energy, fragment& f) {
+    auto fail = [&] (const char* at, const char* what) {
+      f.error_at = at;
+      f.error = what;
+      return false;
+    };
+
+    // Position of the current token in its line.
+    uint64_t tok = 0;
+
+    // End of the digits last read; a minus sign there is inside a number.
+    const char* digits_end = nullptr;
+
+    // Reads the digits at q into n and moves q after them; len is the
+    // length of the run of digits and signs at q, if known, 0 otherwise.
+    auto digits = [&] (const char*& q, int len, uint64_t& n) {
+      if (len > 0 and len <= 8 and end - q >= 8 and all_digits (q, len)) {
+        n = parse_eight (q, len);
+        digits_end = q += len;
+        return len;
+      }
+      n = 0;
+      const char* b = q;
+      while (q != end and (unsigned) (*q - '0') < 10)
+        n = n * 10 + (*q++ - '0');
+      digits_end = q;
+      return (int) (q - b);
+    };
+
+    auto unsigned_number = [&] (const char* q, int len, uint64_t& n) {
+      auto d = digits (q, len, n);
+      return d > 0 and d <= 10;
+    };
+
+    auto label = [&] (const char* q, int len, std::vector<int64_t>& labels,
+                      std::vector<std::pair<uint64_t, std::string_view>>& big) {
+      const char* b = q;
+      bool neg = q != end and *q == '-';
+      q += neg;
+      uint64_t n;
+      auto d = digits (q, len - neg, n);
+      if (d == 0)
+        return false;
+      if (d <= 18)
+        labels.push_back (neg ? -(int64_t) n : (int64_t) n);
+      else {
+        int64_t x;
+        if (std::from_chars (b, q, x).ec == std::errc ())
+          labels.push_back (x);
+        else {
+          big.push_back ({ labels.size (), { b, (size_t) (q - b) } });
+          labels.push_back (0);
+        }
+      }
+      return true;
+    };
+
+    auto end_line = [&] (const char* at) {
+      if (energy ? tok < 2 or tok % 2 : tok < 3)
+        return fail (at, tok ? "incomplete vertex line" : "empty line");
+      tok = 0;
+      return true;
+    };
+
+    // Successors come first, as they are the most frequent tokens.
+    const uint64_t first_succ = energy ? 2 : 3;
+    auto token = [&] (const char* q, int len) {
+      uint64_t n;
+      if (tok >= first_succ and (not energy or tok % 2 == 0)) {
+        if (not unsigned_number (q, len, n) or n > std::numeric_limits<vertex_t>::max ())
+          return fail (q, "bad successor");
+        f.targets.push_back (n);
+      }
+      else if (tok >= first_succ) {
+        if (not label (q, len, f.edge_labels, f.big_edge_labels))
+          return fail (q, "bad weight");
+      }
+      else if (tok == 0) {
+        if (not unsigned_number (q, len, n))
+          return fail (q, "bad vertex number");
+        f.ids.push_back (n);
+        f.first_edge.push_back (f.targets.size ());
+      }
+      else if (tok == first_succ - 1) {
+        if (not unsigned_number (q, len, n) or n > 1)
+          return fail (q, "owner should be 0 or 1");
+        f.owners.push_back (n);
+      }
+      else if (not label (q, len, f.vertex_labels, f.big_vertex_labels))
+        return fail (q, "bad priority");
+      if (digits_end != end and *digits_end == '-')
+        return fail (digits_end, "unexpected character");
+      ++tok;
+      return true;
+    };
+
+    // The only words are start lines, which are parsed without SIMD; the
+    // scan then resumes after them.
+    auto start_line = [&] (const char*& q) {
+      if (tok != 0 or std::string_view (q, std::min<size_t> (5, end - q)) != "start")
+        return fail (q, "unexpected character");
+      q += 5;
+      while (q != end and (*q == ' ' or *q == '\t'))
+        ++q;
+      uint64_t n;
+      const char* b = q;
+      while (q != end and (unsigned) (*q - '0') < 10)
+        ++q;
+      if (std::from_chars (b, q, n).ec != std::errc ())
+        return fail (b, "bad start vertex");
+      while (q != end and (*q == ' ' or *q == '\t'))
+        ++q;
+      if (q == end or *q != ';')
+        return fail (q, "expected ;");
+      f.start = n;
+      ++q;
+      return true;
+    };
+
+    uint64_t in_quote = 0, prev_num = 0;
+    char pad[64];
+    for (const char* base = p; base < end; ) {
+      const char* s = base;
+      if (end - base < 64) {
+        std::memset (pad, ' ', 64);
+        std::memcpy (pad, base, end - base);
+        s = pad;
+      }
+      block b = classify (s);
+      uint64_t quoted = prefix_xor (b.quote) ^ in_quote;
+      in_quote = (uint64_t) ((int64_t) quoted >> 63);
+      uint64_t num = b.num & ~quoted;
+      uint64_t starts = num & ~(num << 1 | prev_num);
+      prev_num = num >> 63;
+      uint64_t events = starts | (b.semi & ~quoted) | (b.other & ~quoted & ~b.quote);
+
+      const char* resume = nullptr;
+      for (; events; events &= events - 1) {
+        int i = std::countr_zero (events);
+        const char* q = base + i;
+        uint64_t bit = events & -events;
+        if (bit & starts) {
+          // Length of the number, unless it runs into the next block.
+          int len = std::countr_one (num >> i);
+          if (not token (q, i + len < 64 ? len : 0))
+            return false;
+        }
+        else if (bit & b.semi) {
+          if (not end_line (q))
+            return false;
+        }
+        else {
+          if (not start_line (q))
+            return false;
+          resume = q;
+          break;
+        }
+      }
+      if (resume) {
+        base = resume;
+        in_quote = prev_num = 0;
+      }
+      else
+        base += 64;
+    }
+    if (in_quote)
+      return fail (end, "unterminated name");
+    if (tok)
+      return fail (end, "missing ; at the end of the file");
+    return true;
+  }
+
+  // Start of the line after the first ";\n" at or after p, or end.
+  inline const char* next_line_end (const char* p, const char* end) {
+    while ((p = (const char*) std::memchr (p, ';', end - p)))
+      if (++p != end and *p == '\n')
+        return p + 1;
+    return end;
+  }
+
+  // Concatenates the fragments, in parallel, renumbering their lines and
+  // edges.
+  inline fragment merge (std::vector<fragment>& frags, unsigned jobs) {
+    size_t k = frags.size ();
+    fragment m;
+    for (auto&& fr : frags)
+      if (fr.start != PG_NO_START)
+        m.start = fr.start;
+
+    // Offsets of each fragment in one of the vectors, and room in m for all.
+    auto prefix = [&] (auto field) {
+      std::vector<uint64_t> off (k + 1);
+      for (size_t c = 0; c < k; ++c)
+        off[c + 1] = off[c] + (frags[c].*field).size ();
+      (m.*field).resize (off[k]);
+      return off;
+    };
+    auto lines = prefix (&fragment::ids);
+    auto edges = prefix (&fragment::targets);
+    auto vlabels = prefix (&fragment::vertex_labels);
+    auto elabels = prefix (&fragment::edge_labels);
+    auto bigv = prefix (&fragment::big_vertex_labels);
+    auto bige = prefix (&fragment::big_edge_labels);
+    prefix (&fragment::first_edge);
+    prefix (&fragment::owners);
+
+    parallel_for (k, jobs, [&] (size_t c) {
+      auto& fr = frags[c];
+      auto l = lines[c], e = edges[c];
+      std::copy (fr.ids.begin (), fr.ids.end (), m.ids.begin () + l);
+      std::copy (fr.owners.begin (), fr.owners.end (), m.owners.begin () + l);
+      std::transform (fr.first_edge.begin (), fr.first_edge.end (), m.first_edge.begin () + l,
+                      [&] (uint64_t i) { return i + e; });
+      std::copy (fr.targets.begin (), fr.targets.end (), m.targets.begin () + e);
+      std::copy (fr.vertex_labels.begin (), fr.vertex_labels.end (), m.vertex_labels.begin () + vlabels[c]);
+      std::copy (fr.edge_labels.begin (), fr.edge_labels.end (), m.edge_labels.begin () + elabels[c]);
+      for (size_t i = 0; i < fr.big_vertex_labels.size (); ++i)
+        m.big_vertex_labels[bigv[c] + i] = { fr.big_vertex_labels[i].first + l, fr.big_vertex_labels[i].second };
+      for (size_t i = 0; i < fr.big_edge_labels.size (); ++i)
+        m.big_edge_labels[bige[c] + i] = { fr.big_edge_labels[i].first + e, fr.big_edge_labels[i].second };
+      fr = fragment ();
+    });
+    return m;
+  }
+}
+
+// Parses text into g, with up to `jobs` threads (0 for one per core).  Labels
+// of g.big_labels point into text.  On failure, returns false and sets err,
+// with the byte offset of the error.
+inline bool parse_pg (std::string_view text, pg_game& g, std::string& err, unsigned jobs = 1) {
+  using namespace pg_detail;
+  const char* p = text.data (), *end = p + text.size ();
+  auto fail = [&] (const char* at, const std::string& what) {
+    err = "byte " + std::to_string (at - text.data ()) + ": " + what;
+    return false;
+  };
+
+  // Header
+  while (p != end and std::isspace ((unsigned char) *p))
+    ++p;
+  auto kw = std::string_view (p, std::min<size_t> (6, end - p));
+  if (kw != "parity" and kw != "energy")
+    return fail (p, "expected parity or energy");
+  g = pg_game ();
+  g.energy = kw == "energy";
+  p = (const char*) std::memchr (p, ';', end - p);
+  if (not p)
+    return fail (end, "expected ;");
+  ++p;
+
+  if (jobs == 0)
+    jobs = std::thread::hardware_concurrency ();
+  size_t nchunks = std::clamp<size_t> ((end - p) / pg_min_chunk, 1, jobs);
+  std::vector<const char*> cuts { p };
+  for (size_t c = 1; c < nchunks; ++c) {
+    auto q = next_line_end (std::max (cuts.back (), p + (end - p) / nchunks * c), end);
+    if (q != end)
+      cuts.push_back (q);
+  }
+  cuts.push_back (end);
+
+  std::vector<fragment> frags (cuts.size () - 1);
+  parallel_for (frags.size (), jobs, [&] (size_t c) {
+    parse_lines (cuts[c], cuts[c + 1], g.energy, frags[c]);
+  });
+  for (auto&& fr : frags)
+    if (fr.error)
+      return fail (fr.error_at, fr.error);
+  fragment f = frags.size () == 1 ? std::move (frags[0]) : merge (frags, jobs);
+
+  uint64_t n = f.ids.size ();
+  g.start = f.start;
+  f.first_edge.push_back (f.targets.size ());
+
+  // Lay out the vertices by number.
+  bool in_order = true;
+  for (uint64_t l = 0; l < n and in_order; ++l)
+    in_order = f.ids[l] == l;
+
+  if (in_order) {
+    g.owners = std::move (f.owners);
+    g.graph.offsets = std::move (f.first_edge);
+    g.graph.targets = std::move (f.targets);
+    if (g.energy) {
+      g.labels = std::move (f.edge_labels);
+      g.big_labels = std::move (f.big_edge_labels);
+    }
+    else {
+      g.labels = std::move (f.vertex_labels);
+      g.big_labels = std::move (f.big_vertex_labels);
+    }
+  }
+  else {
+    std::vector<uint64_t> line_of (n, PG_NO_START);
+    for (uint64_t l = 0; l < n; ++l) {
+      if (f.ids[l] >= n)
+        return fail (end, "vertex " + std::to_string (f.ids[l]) + " out of range");
+      if (line_of[f.ids[l]] != PG_NO_START)
+        return fail (end, "vertex " + std::to_string (f.ids[l]) + " defined twice");
+      line_of[f.ids[l]] = l;
+    }
+    // Indices of labels that do not fit, by line or by edge in file order.
+    std::vector<std::string_view> big_text;
+    std::vector<uint64_t> big_index (g.energy ? f.targets.size () : n, PG_NO_START);
+    for (auto&& [i, t] : g.energy ? f.big_edge_labels : f.big_vertex_labels) {
+      big_index[i] = big_text.size ();
+      big_text.push_back (t);
+    }
+
+    g.owners.resize (n);
+    g.graph.offsets.resize (n + 1);
+    g.graph.targets.resize (f.targets.size ());
+    g.labels.resize (g.energy ? f.targets.size () : n);
+    uint64_t e = 0;
+    for (uint64_t v = 0; v < n; ++v) {
+      auto l = line_of[v];
+      g.owners[v] = f.owners[l];
+      g.graph.offsets[v] = e;
+      if (not g.energy) {
+        g.labels[v] = f.vertex_labels[l];
+        if (big_index[l] != PG_NO_START)
+          g.big_labels.push_back ({ v, big_text[big_index[l]] });
+      }
+      for (auto i = f.first_edge[l]; i < f.first_edge[l + 1]; ++i, ++e) {
+        g.graph.targets[e] = f.targets[i];
+        if (g.energy) {
+          g.labels[e] = f.edge_labels[i];
+          if (big_index[i] != PG_NO_START)
+            g.big_labels.push_back ({ e, big_text[big_index[i]] });
+        }
+      }
+    }
+    g.graph.offsets[n] = e;
+  }
+
+  for (auto t : g.graph.targets)
+    if (t >= n)
+      return fail (end, "successor " + std::to_string (t) + " is not a vertex");
+  if (g.start != PG_NO_START and g.start >= n)
+    return fail (end, "start vertex " + std::to_string (g.start) + " is not a vertex");
+  return true;
+}
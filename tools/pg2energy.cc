@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <gmp.h>
+
+#include "energy-sym.hh"
+#include "pg-parser.hh"
+#include "pgb.hh"
+#include "potential.hh"
+#include "power-table.hh"
+#include "text-writer.hh"
+
+#define die(S)                                  \
+  do {                                          \
+  std::cerr << S << "\n";                       \
+  exit (2);                                     \
+  } while (0)
+
+//////////////////// Parity to energy
+//
+// This is the reduction used by friedmann-switch-best -e, for any parity game
+// with n vertices: each edge leaving a vertex of priority p weighs (-n)^p, and
+// player 0 wins the parity game from a vertex iff player 0 wins the energy
+// game from it with some finite initial credit.  Owners are kept.
+//
+// With -p, the game is perturbed by a random potential: each vertex v is given
+// an integer pot(v) drawn uniformly in [-n^P, n^P], where P is the largest
+// priority, and the edge (u, v) weighs (-n)^p(u) + pot(v) - pot(u).  This does
+// not change the winning regions, but hides the structure of the weights.
+//
+// The game is mapped and parsed whole with parse_pg, then written vertex by
+// vertex.  The powers are computed once per distinct priority (see
+// power-table.hh), and the perturbed weights as each edge is written (see
+// potential.hh); with --format pgb, pgb_writer keeps the whole output in
+// memory until the end.
+
+void usage (char* prog) {
+  std::cerr << "usage: " << prog << " [-p [-s SEED]] [--format pg|pgb|sym] GAME.pg [OUTPUT]\n"
+            << "  Reduce a parity game to an energy game; see pg2energy.cc.\n"
+            << "  -p: perturb the game by applying a random potential.\n"
+            << "  -s: seed of the potential (default: 3).\n"
+            << "  The output (default: stdout) is in PGSolver text (pg, the default),\n"
+            << "  binary (pgb), or text with the weights as powers (sym, see\n"
+            << "  energy-sym.hh).  Vertex names are not kept.\n";
+  exit (1);
+}
+
+int main (int argc, char** argv) {
+  char* prog = argv[0];
+  bool perturbed = false, pgb = false, sym = false;
+  unsigned long seed = 3;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "-p")
+      perturbed = true;
+    else if (a == "-s" and i + 1 < argc)
+      seed = std::stoul (argv[++i]);
+    else if (a == "--format" and i + 1 < argc) {
+      std::string f = argv[++i];
+      if (f != "pg" and f != "pgb" and f != "sym") usage (prog);
+      pgb = f == "pgb";
+      sym = f == "sym";
+    }
+    else if (a.starts_with ("-"))
+      usage (prog);
+    else
+      files.push_back (a);
+  }
+  if (files.empty () or files.size () > 2) usage (prog);
+
+  mapped_file text;
+  if (not text.open (files[0])) die (files[0] << ": cannot open file");
+  pg_game g;
+  std::string err;
+  if (not parse_pg (text.text (), g, err, 0)) die (files[0] << ": " << err);
+  if (g.energy) die (files[0] << ": not a parity game");
+  if (g.nvertices () == 0) die (files[0] << ": empty game");
+  if (not g.big_labels.empty () or std::any_of (g.labels.begin (), g.labels.end (), [] (auto p) { return p < 0; }))
+    die (files[0] << ": priorities should be natural numbers");
+
+  size_t n = g.nvertices ();
+  power_table powers (-(int64_t) n, { g.labels.begin (), g.labels.end () });
+  std::vector<uint32_t> prio (n); // Position in powers
+  for (vertex_t v = 0; v < n; ++v)
+    prio[v] = powers.index (g.labels[v]);
+
+  std::optional<potential> pot;
+  std::optional<potential::printer> print;
+  if (perturbed) {
+    mpz_t bound;
+    mpz_init (bound);
+    mpz_abs (bound, powers.largest ());
+    pot.emplace (n, bound, seed);
+    print.emplace (*pot);
+    if (not pgb)
+      pot->decimals ();
+    mpz_clear (bound);
+  }
+  auto weight = [&] (vertex_t u, vertex_t v) {
+    return perturbed ? print->weight (powers.power (prio[u]), u, v) : powers.power (prio[u]);
+  };
+
+  text_writer out = files.size () == 2 ? text_writer (files[1]) : text_writer (1);
+  if (not out.good ()) die (files[1] << ": cannot open file for writing");
+  if (pgb) {
+    pgb_writer bin (PGB_ENERGY, true);
+    if (g.start != PG_NO_START)
+      bin.start (g.start);
+    std::vector<vertex_t> succ;
+    for (vertex_t v = 0; v < n; ++v) {
+      bin.vertex (g.owners[v]);
+      auto s = g.graph.succ (v);
+      succ.assign (s.begin (), s.end ());
+      std::sort (succ.begin (), succ.end ());
+      for (auto t : succ) {
+        bin.edge (t);
+        bin.label (weight (v, t));
+      }
+    }
+    bin.write (out);
+  }
+  else {
+    // With sym, the weights are (-n)^p(u) + (pot(v) - pot(u)), the latter
+    // being given by a printer from u with weight 0.
+    mpz_t zero;
+    mpz_init (zero);
+    out << (sym ? "energy-sym " : "energy ") << n << ";\n";
+    if (g.start != PG_NO_START)
+      out << "start " << g.start << ";\n";
+    for (vertex_t v = 0; v < n; ++v) {
+      out << v << ' ' << (int) g.owners[v] << ' ';
+      if (perturbed)
+        print->from (v, sym ? zero : powers.power (prio[v]));
+      bool first = true;
+      for (auto t : g.graph.succ (v)) {
+        if (not first) out << ',';
+        first = false;
+        out << t << ' ';
+        if (sym)
+          write_sym_weight (out, -(int64_t) n, g.labels[v], perturbed ? print->text (t) : "");
+        else if (perturbed)
+          out << print->text (t);
+        else
+          out << powers.text (prio[v]);
+      }
+      out << ";\n";
+    }
+    mpz_clear (zero);
+  }
+  if (not out.close ())
+    die ((files.size () == 2 ? files[1] : "stdout") << ": write error");
+}
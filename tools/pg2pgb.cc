@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <gmp.h>
+
+#include "pg-parser.hh"
+#include "pgb.hh"
+#include "text-writer.hh"
+
+#define die(S)                                  \
+  do {                                          \
+  std::cerr << S << "\n";                       \
+  exit (2);                                     \
+  } while (0)
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main (int argc, char** argv) {
+  if (argc < 2 or argc > 3) {
+    std::cerr << "usage: " << argv[0] << " GAME.pg [GAME.pgb]\n"
+              << "  Convert a game in PGSolver text to the binary format of pgb.hh.\n"
+              << "  The output defaults to the input name with extension .pgb.\n";
+    return 1;
+  }
+  std::string in = argv[1], out_name;
+  if (argc == 3)
+    out_name = argv[2];
+  else
+    out_name = (in.ends_with (".pg") ? in.substr (0, in.size () - 3) : in) + ".pgb";
+
+  mapped_file text;
+  if (not text.open (in)) die (in << ": cannot open file");
+  pg_game g;
+  std::string err;
+  if (not parse_pg (text.text (), g, err, 0)) die (in << ": " << err);
+
+  bool bignum = not g.big_labels.empty ();
+  pgb_writer bin (g.energy ? PGB_ENERGY : PGB_PARITY, bignum);
+  if (g.start != PG_NO_START)
+    bin.start (g.start);
+
+  mpz_t z;
+  mpz_init (z);
+  std::string buf;
+  auto label = [&] (uint64_t i) {
+    if (not bignum) {
+      bin.label (g.labels[i]);
+      return;
+    }
+    auto big = std::lower_bound (g.big_labels.begin (), g.big_labels.end (), i,
+                                 [] (auto& b, uint64_t i) { return b.first < i; });
+    if (big != g.big_labels.end () and big->first == i) {
+      buf.assign (big->second);
+      mpz_set_str (z, buf.c_str (), 10);
+      bin.label (z);
+    }
+    else {
+      mpz_set_si (z, g.labels[i]);
+      bin.label (z);
+    }
+  };
+
+  // Successors are written sorted, with their weights.
+  std::vector<uint64_t> edges;
+  for (uint64_t v = 0; v < g.nvertices (); ++v) {
+    bin.vertex (g.owners[v]);
+    if (not g.energy)
+      label (v);
+    edges.resize (g.graph.offsets[v + 1] - g.graph.offsets[v]);
+    std::iota (edges.begin (), edges.end (), g.graph.offsets[v]);
+    std::stable_sort (edges.begin (), edges.end (),
+                      [&] (auto a, auto b) { return g.graph.targets[a] < g.graph.targets[b]; });
+    for (auto e : edges) {
+      bin.edge (g.graph.targets[e]);
+      if (g.energy)
+        label (e);
+    }
+  }
+  mpz_clear (z);
+
+  text_writer out (out_name);
+  if (not out.good ()) die (out_name << ": cannot open file for writing");
+  if (not bin.write (out) or not out.close ())
+    die (out_name << ": write error");
+}
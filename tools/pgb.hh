@@ -0,0 +1,314 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gmp.h>
+
+#include "text-writer.hh"
+
+//////////////////// Binary game format (.pgb)
+//
+// A .pgb file holds a parity or energy game in a form that can be used
+// directly after mmap, in native byte order:
+//
+//   pgb_header
+//   owners      uint8_t  [nvertices]
+//   labels      int64_t  [nlabels]       priorities, or edge weights
+//   offsets     uint64_t [nvertices + 1] CSR offsets into targets
+//   targets     uint32_t [nedges]        successors, sorted per vertex
+//   pool        bignum labels, if any
+//
+// For parity games (kind PGB_PARITY), labels are the vertex priorities; for
+// energy games (PGB_ENERGY), they are the edge weights, in the order of the
+// targets.  When weight_width is 8, labels are the values themselves.  When
+// it is 0, labels are byte offsets into the pool, where each value is stored
+// as an int64_t GMP size (negative for negative numbers) followed by the
+// absolute value in as many 64-bit limbs.  Every section starts at a
+// multiple of 8 bytes, at the offset given in the header.  Vertex names are
+// not kept.
+//
+// Files are not trusted: pgb_game::open checks, in one pass over the
+// offsets, targets and labels, that every access it allows stays in the
+// file.
+
+constexpr char     PGB_MAGIC[4] = { 'P', 'G', 'B', '\0' };
+constexpr uint32_t PGB_VERSION  = 1;
+constexpr uint32_t PGB_PARITY   = 0, PGB_ENERGY = 1;
+constexpr uint64_t PGB_NO_START = ~uint64_t {0};
+
+struct pgb_header {
+    char     magic[4];
+    uint32_t version;
+    uint32_t kind;
+    uint32_t weight_width;    // 8, or 0 for bignum labels in the pool
+    uint64_t nvertices, nedges;
+    int64_t  max_priority;    // largest label, or its bit size for bignums
+    uint64_t start;           // start vertex, or PGB_NO_START
+    uint64_t owners_offset, labels_offset, offsets_offset, targets_offset;
+    uint64_t pool_offset, pool_size;
+};
+
+static_assert (sizeof (pgb_header) % 8 == 0);
+static_assert (GMP_NUMB_BITS == 64, "pool limbs are 64-bit");
+
+// Builds a game vertex by vertex, in increasing order, then writes it out.
+// The whole game is kept in memory.  A writer created without bignum
+// labels switches to them at the first label that does not fit in an
+// int64_t.
+class pgb_writer {
+  public:
+    pgb_writer (uint32_t kind, bool bignum) : bignum (bignum) {
+      std::memset (&hdr, 0, sizeof (hdr));
+      std::memcpy (hdr.magic, PGB_MAGIC, sizeof (PGB_MAGIC));
+      hdr.version = PGB_VERSION;
+      hdr.kind = kind;
+      hdr.weight_width = bignum ? 0 : 8;
+      hdr.start = PGB_NO_START;
+      offsets.push_back (0);
+    }
+
+    void start (uint64_t v) { hdr.start = v; }
+
+    // Starts the next vertex.
+    void vertex (uint8_t owner) {
+      if (not owners.empty ())
+        offsets.push_back (targets.size ());
+      owners.push_back (owner);
+    }
+
+    // Adds a successor to the current vertex.
+    void edge (uint32_t to) { targets.push_back (to); }
+
+    // Sets the priority of the current vertex, or the weight of the last edge.
+    void label (int64_t l) {
+      if (bignum) {
+        mpz_t z;
+        mpz_init_set_si (z, l);
+        label (z);
+        mpz_clear (z);
+        return;
+      }
+      if (labels.empty () or l > hdr.max_priority)
+        hdr.max_priority = l;
+      labels.push_back (l);
+    }
+
+    void label (mpz_srcptr z) {
+      if (not bignum and mpz_fits_slong_p (z)) {
+        label ((int64_t) mpz_get_si (z));
+        return;
+      }
+      if (not bignum)
+        use_bignum ();
+      int64_t size = z->_mp_size, nlimbs = std::abs (size);
+      labels.push_back (pool.size () * 8);
+      pool.push_back (size);
+      pool.insert (pool.end (), z->_mp_d, z->_mp_d + nlimbs);
+      hdr.max_priority = std::max (hdr.max_priority, (int64_t) mpz_sizeinbase (z, 2));
+    }
+
+    // Writes the game; returns out.good ().
+    bool write (text_writer& out) {
+      offsets.push_back (targets.size ());
+      hdr.nvertices = owners.size ();
+      hdr.nedges = targets.size ();
+
+      uint64_t pos = sizeof (hdr);
+      auto section = [&] (uint64_t bytes) {
+        auto start = pos;
+        pos += (bytes + 7) & ~uint64_t {7};
+        return start;
+      };
+      hdr.owners_offset  = section (owners.size ());
+      hdr.labels_offset  = section (labels.size () * 8);
+      hdr.offsets_offset = section (offsets.size () * 8);
+      hdr.targets_offset = section (targets.size () * 4);
+      hdr.pool_size      = pool.size () * 8;
+      hdr.pool_offset    = section (hdr.pool_size);
+
+      auto put = [&] (const void* data, uint64_t bytes) {
+        out << std::string_view ((const char*) data, bytes);
+        static const char zeros[8] = {};
+        out << std::string_view (zeros, -bytes & 7);
+      };
+      put (&hdr, sizeof (hdr));
+      put (owners.data (), owners.size ());
+      put (labels.data (), labels.size () * 8);
+      put (offsets.data (), offsets.size () * 8);
+      put (targets.data (), targets.size () * 4);
+      put (pool.data (), pool.size () * 8);
+      offsets.pop_back ();
+      return out.good ();
+    }
+
+  private:
+    // Moves the labels so far to the pool.
+    void use_bignum () {
+      std::vector<int64_t> small;
+      std::swap (small, labels);
+      bignum = true;
+      hdr.weight_width = 0;
+      hdr.max_priority = 0;
+      for (auto l : small)
+        label (l);
+    }
+
+    bool bignum;
+    pgb_header hdr;
+    std::vector<uint8_t> owners;
+    std::vector<int64_t> labels;
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> targets;
+    std::vector<uint64_t> pool;
+};
+
+// Read-only view of a .pgb file, mapped in memory.
+class pgb_game {
+  public:
+    pgb_game () = default;
+    pgb_game (const pgb_game&) = delete;
+
+    ~pgb_game () {
+      if (base)
+        munmap (base, size);
+    }
+
+    // Maps path and checks its structure.  On failure, returns false and
+    // error () says why.
+    bool open (const std::string& path) {
+      int fd = ::open (path.c_str (), O_RDONLY);
+      if (fd < 0)
+        return fail ("cannot open file");
+      struct stat st;
+      if (fstat (fd, &st) != 0 or st.st_size < (off_t) sizeof (pgb_header)) {
+        ::close (fd);
+        return fail ("file too short");
+      }
+      size = st.st_size;
+      void* p = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close (fd);
+      if (p == MAP_FAILED)
+        return fail ("cannot map file");
+      base = p;
+      hdr = (const pgb_header*) base;
+
+      if (std::memcmp (hdr->magic, PGB_MAGIC, sizeof (PGB_MAGIC)) != 0)
+        return fail ("not a pgb file");
+      if (hdr->version != PGB_VERSION)
+        return fail ("unsupported pgb version");
+      if (hdr->kind != PGB_PARITY and hdr->kind != PGB_ENERGY)
+        return fail ("unknown game kind");
+      if (hdr->weight_width != 8 and hdr->weight_width != 0)
+        return fail ("unsupported weight width");
+
+      const uint64_t n = hdr->nvertices, m = hdr->nedges;
+      auto nlabels = hdr->kind == PGB_PARITY ? n : m;
+      if (n == ~uint64_t {0} or
+          not fits (hdr->owners_offset, n, 1) or
+          not fits (hdr->labels_offset, nlabels, 8) or
+          not fits (hdr->offsets_offset, n + 1, 8) or
+          not fits (hdr->targets_offset, m, 4) or
+          not fits (hdr->pool_offset, hdr->pool_size, 1))
+        return fail ("truncated file");
+
+      owners_ = at<uint8_t> (hdr->owners_offset);
+      labels_ = at<int64_t> (hdr->labels_offset);
+      offsets_ = at<uint64_t> (hdr->offsets_offset);
+      targets_ = at<uint32_t> (hdr->targets_offset);
+      pool_ = at<int64_t> (hdr->pool_offset);
+
+      if (offsets_[0] != 0 or offsets_[n] != m)
+        return fail ("inconsistent edge count");
+      for (uint64_t v = 0; v < n; ++v)
+        if (offsets_[v] > offsets_[v + 1])
+          return fail ("decreasing offsets");
+      for (uint64_t e = 0; e < m; ++e)
+        if (targets_[e] >= n)
+          return fail ("successor out of range");
+      if (bignum ()) {
+        // Each label is the offset of a size, followed by that many limbs.
+        uint64_t pool_words = hdr->pool_size / 8;
+        for (uint64_t i = 0; i < nlabels; ++i) {
+          uint64_t w = labels_[i] / 8;
+          if (labels_[i] < 0 or labels_[i] % 8 or w >= pool_words or
+              pool_[w] == std::numeric_limits<int64_t>::min () or
+              (uint64_t) std::abs (pool_[w]) > pool_words - w - 1)
+            return fail ("bignum label out of the pool");
+        }
+      }
+      return true;
+    }
+
+    const std::string& error () const { return err; }
+
+    const pgb_header& header () const { return *hdr; }
+    bool energy () const { return hdr->kind == PGB_ENERGY; }
+    bool bignum () const { return hdr->weight_width == 0; }
+    uint64_t nvertices () const { return hdr->nvertices; }
+    uint64_t nedges () const { return hdr->nedges; }
+
+    uint8_t owner (uint64_t v) const { return owners_[v]; }
+
+    // Index of the first successor of v among the targets and edge labels.
+    uint64_t first_edge (uint64_t v) const { return offsets_[v]; }
+
+    std::span<const uint32_t> succ (uint64_t v) const {
+      return { targets_ + offsets_[v], targets_ + offsets_[v + 1] };
+    }
+
+    // Label i, when weight_width is 8.
+    int64_t label (uint64_t i) const { return labels_[i]; }
+
+    // Pool entry of label i, when bignum (): its size and limbs, which
+    // identify the value, as GMP integers are normalized.
+    std::string_view label_bytes (uint64_t i) const {
+      auto entry = pool_ + labels_[i] / 8;
+      return { (const char*) entry, 8 * (1 + (size_t) std::abs (entry[0])) };
+    }
+
+    // Label i as a read-only GMP integer pointing into the file; no mpz_clear.
+    mpz_srcptr label_mpz (uint64_t i, mpz_t storage) const {
+      if (not bignum ())
+        mpz_set_si (storage, labels_[i]); // storage must be initialized
+      else {
+        auto entry = pool_ + labels_[i] / 8;
+        mpz_roinit_n (storage, (const mp_limb_t*) (entry + 1), entry[0]);
+      }
+      return storage;
+    }
+
+  private:
+    bool fail (const char* what) { err = what; return false; }
+
+    // Whether count items of the given width, at offset, are in the file.
+    bool fits (uint64_t offset, uint64_t count, uint64_t width) const {
+      uint64_t bytes;
+      return offset % 8 == 0 and offset <= size and
+        not __builtin_mul_overflow (count, width, &bytes) and bytes <= size - offset;
+    }
+
+    template <typename T>
+    const T* at (uint64_t offset) const { return (const T*) ((const char*) base + offset); }
+
+    void* base = nullptr;
+    size_t size = 0;
+    const pgb_header* hdr = nullptr;
+    const uint8_t* owners_ = nullptr;
+    const int64_t* labels_ = nullptr;
+    const uint64_t* offsets_ = nullptr;
+    const uint32_t* targets_ = nullptr;
+    const int64_t* pool_ = nullptr;
+    std::string err;
+};
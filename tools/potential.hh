@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gmp.h>
+
+#include "parallel.hh"
+
+//////////////////// Random potentials
+//
+// Perturbing an energy game by a potential pot, that is, adding pot(v) -
+// pot(u) to the weight of each edge (u, v), does not change who wins where,
+// but hides the structure of the weights.  The potentials are drawn uniformly
+// in [-bound, bound] by GMP's Mersenne Twister, straight into an array of
+// mpz_t.  The weights are computed by a potential::printer, one per thread,
+// in a scratch value that it owns, so that no integer is allocated per edge
+// once the scratch value has grown to the largest weight.
+//
+// Converting each weight to decimal costs far more than computing it, so for
+// text output the weights of the edges leaving u are instead given as sums of
+// two decimal numbers: w - pot(u), converted once per vertex by from (), and
+// pot(v), converted once per game by decimals ().  text () adds them digit by
+// digit into a reused buffer, in time linear in their length.
+
+class potential {
+  private:
+    struct decimal {
+        bool negative = false;
+        std::string digits; // Of the absolute value
+    };
+
+  public:
+    potential (uint64_t nvertices, mpz_srcptr bound, unsigned long seed) :
+      n (nvertices), pot (std::make_unique<mpz_t[]> (nvertices)) {
+      gmp_randstate_t rng;
+      gmp_randinit_mt (rng);
+      gmp_randseed_ui (rng, seed);
+      mpz_t range;
+      mpz_init (range);
+      mpz_mul_2exp (range, bound, 1);
+      mpz_add_ui (range, range, 1);
+      for (uint64_t v = 0; v < n; ++v) {
+        mpz_init (pot[v]);
+        mpz_urandomm (pot[v], rng, range);
+        mpz_sub (pot[v], pot[v], bound);
+      }
+      mpz_clear (range);
+      gmp_randclear (rng);
+    }
+
+    potential (const potential&) = delete;
+
+    ~potential () {
+      for (uint64_t v = 0; v < n; ++v)
+        mpz_clear (pot[v]);
+    }
+
+    mpz_srcptr operator[] (uint64_t v) const { return pot[v]; }
+
+    // Converts the potentials to decimal, for printer::text ().
+    void decimals (unsigned jobs = 1) {
+      pot_text.resize (n);
+      parallel_for ((n + 1023) / 1024, jobs, [&] (size_t chunk) {
+        for (uint64_t v = chunk * 1024; v < n and v < (chunk + 1) * 1024; ++v)
+          pot_text[v] = to_decimal (pot[v]);
+      });
+    }
+
+    class printer {
+      public:
+        explicit printer (const potential& pot) : p (pot) { mpz_init (scratch); }
+
+        printer (const printer&) = delete;
+
+        ~printer () { mpz_clear (scratch); }
+
+        // w + pot(v) - pot(u); valid until the next call.
+        mpz_srcptr weight (mpz_srcptr w, uint64_t u, uint64_t v) {
+          mpz_add (scratch, w, p.pot[v]);
+          mpz_sub (scratch, scratch, p.pot[u]);
+          return scratch;
+        }
+
+        // Sets the vertex whose edges text () gives the weight of, and the
+        // weight w before perturbation.
+        void from (uint64_t u, mpz_srcptr w) {
+          mpz_sub (scratch, w, p.pot[u]);
+          base = to_decimal (scratch);
+        }
+
+        // Decimal text of w + pot(v) - pot(u); valid until the next call.
+        // decimals () must have been called.
+        std::string_view text (uint64_t v) {
+          const decimal& a = base, &b = p.pot_text[v];
+
+          // The sum of magnitudes if the signs agree, otherwise the difference
+          // of the larger and the smaller one, with the sign of the larger.
+          bool add = a.negative == b.negative;
+          bool swap = not add and (a.digits.size () < b.digits.size ()
+                                   or (a.digits.size () == b.digits.size () and a.digits < b.digits));
+          auto& x = swap ? b : a, &y = swap ? a : b;
+          size_t len = std::max (x.digits.size (), y.digits.size ()) + 1;
+          buf.resize (len + 1);
+          char* end = buf.data () + buf.size (), *q = end;
+          const char* xd = x.digits.data () + x.digits.size (), *yd = y.digits.data () + y.digits.size ();
+          int carry = 0;
+          for (size_t i = 0; i < x.digits.size () or i < y.digits.size (); ++i) {
+            int d = (i < x.digits.size () ? *--xd - '0' : 0);
+            int e = (i < y.digits.size () ? *--yd - '0' : 0);
+            d = add ? d + e + carry : d - e - carry;
+            carry = add ? d >= 10 : d < 0;
+            *--q = '0' + (add ? d - 10 * carry : d + 10 * carry);
+          }
+          if (carry)
+            *--q = '1';
+          while (q < end - 1 and *q == '0')
+            ++q;
+          if (x.negative and not (q == end - 1 and *q == '0'))
+            *--q = '-';
+          return { q, (size_t) (end - q) };
+        }
+
+      private:
+        const potential& p;
+        mpz_t scratch;
+        decimal base;
+        std::string buf;
+    };
+
+  private:
+    static decimal to_decimal (mpz_srcptr z) {
+      decimal d;
+      d.negative = mpz_sgn (z) < 0;
+      d.digits.resize (mpz_sizeinbase (z, 10) + 2);
+      mpz_get_str (d.digits.data (), 10, z);
+      d.digits.resize (std::char_traits<char>::length (d.digits.data ()));
+      if (d.negative)
+        d.digits.erase (0, 1);
+      return d;
+    }
+
+    uint64_t n;
+    std::unique_ptr<mpz_t[]> pot;
+    std::vector<decimal> pot_text;
+};
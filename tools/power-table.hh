@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gmp.h>
+
+//////////////////// Tables of powers
+//
+// The reduction from parity games to energy games weighs the edges leaving a
+// vertex of priority p with (-n)^p, which has thousands of digits in large
+// games.  A power_table computes these powers once per distinct exponent, in
+// increasing order, each from the previous one, so that a game with P
+// distinct priorities costs P multiplications instead of one exponentiation
+// per edge.  The decimal text of a power is also computed once, on first use,
+// so that text output is a copy.  text () fills that cache, so it may only be
+// called concurrently for distinct powers, or once all have been converted.
+
+class power_table {
+  public:
+    // The powers base^e for the given exponents, which may be in any order and
+    // repeated.
+    power_table (int64_t base, std::vector<uint64_t> exponents) {
+      std::sort (exponents.begin (), exponents.end ());
+      exponents.erase (std::unique (exponents.begin (), exponents.end ()), exponents.end ());
+      exps = std::move (exponents);
+      powers = std::make_unique<mpz_t[]> (exps.size ());
+      texts.resize (exps.size ());
+
+      mpz_t step;
+      mpz_init (step);
+      for (size_t i = 0; i < exps.size (); ++i) {
+        mpz_init (powers[i]);
+        if (i == 0) {
+          mpz_set_si (step, base);
+          mpz_pow_ui (powers[i], step, exps[i]);
+        }
+        else if (exps[i] - exps[i - 1] == 1)
+          mpz_mul_si (powers[i], powers[i - 1], base);
+        else {
+          mpz_set_si (step, base);
+          mpz_pow_ui (step, step, exps[i] - exps[i - 1]);
+          mpz_mul (powers[i], powers[i - 1], step);
+        }
+      }
+      mpz_clear (step);
+    }
+
+    power_table (const power_table&) = delete;
+
+    ~power_table () {
+      for (size_t i = 0; i < exps.size (); ++i)
+        mpz_clear (powers[i]);
+    }
+
+    // Number of distinct exponents.
+    size_t size () const { return exps.size (); }
+
+    // Position of the exponent e, which must be one of those given.
+    size_t index (uint64_t e) const {
+      return std::lower_bound (exps.begin (), exps.end (), e) - exps.begin ();
+    }
+
+    uint64_t exponent (size_t i) const { return exps[i]; }
+
+    mpz_srcptr power (size_t i) const { return powers[i]; }
+
+    // The power with the largest exponent, hence the largest absolute value
+    // when |base| > 1; the table must not be empty.
+    mpz_srcptr largest () const { return powers[exps.size () - 1]; }
+
+    std::string_view text (size_t i) {
+      if (texts[i].empty ()) {
+        texts[i].resize (mpz_sizeinbase (powers[i], 10) + 2);
+        mpz_get_str (texts[i].data (), 10, powers[i]);
+        texts[i].resize (std::char_traits<char>::length (texts[i].data ()));
+      }
+      return texts[i];
+    }
+
+  private:
+    std::vector<uint64_t> exps;
+    std::unique_ptr<mpz_t[]> powers;
+    std::vector<std::string> texts;
+};
@@ -6,10 +6,23 @@
 
 using mpfr::mpreal;
 
-#include <boost/multiprecision/gmp.hpp>
-#include <boost/random.hpp>
+#include <gmp.h>
 
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <limits>
 #include <random>
+#include <set>
+#include <sstream>
+
+#include "content-hash.hh"
+#include "counter-rng.hh"
+#include "csr-graph.hh"
+#include "parallel.hh"
+#include "pgb.hh"
+#include "text-writer.hh"
+#include "toml.hh"
 
 //////////////////// Parse options as math expressions, using exprTk and cxxopts
 
@@ -40,6 +53,7 @@ class mpfr_math_expr {
 
     void set_value_str (const std::string& expr) {
       value_str = expr;
+      set = get_called = false;
     }
     const std::string& get_value_str () const {
       return value_str;
@@ -110,6 +124,89 @@ instantiate (mpfr_math_expr::symbol_table);
 instantiate (mpfr_math_expr::all_exprs);
 
 
+//////////////////// Uniform random weights
+
+// Exact uniform integers in [lb, ub]: the limbs of a number of the bit width
+// of ub - lb are filled from a counter_rng, and the number is rejected if it
+// exceeds ub - lb, which happens with probability less than 1/2.  The limbs
+// are reused across draws.
+class mpz_uniform {
+    static_assert (GMP_NUMB_BITS == 64, "limbs are filled with 64 random bits");
+  public:
+    mpz_uniform (mpz_srcptr lb, mpz_srcptr ub) {
+      mpz_inits (this->lb, span, r, nullptr);
+      mpz_set (this->lb, lb);
+      mpz_sub (span, ub, lb);
+      auto bits = mpz_sizeinbase (span, 2);
+      nlimbs = (bits + 63) / 64;
+      top_mask = ~mp_limb_t {0} >> (64 * nlimbs - bits);
+    }
+
+    mpz_uniform (const mpz_uniform&) = delete;
+
+    ~mpz_uniform () {
+      mpz_clears (lb, span, r, nullptr);
+    }
+
+    // The result is valid until the next call.
+    mpz_srcptr operator() (counter_rng& rng) {
+      do {
+        auto limbs = mpz_limbs_write (r, nlimbs);
+        for (size_t i = 0; i < nlimbs; ++i)
+          limbs[i] = rng ();
+        limbs[nlimbs - 1] &= top_mask;
+        mpz_limbs_finish (r, nlimbs);
+      } while (mpz_cmp (r, span) > 0);
+      mpz_add (r, r, lb);
+      return r;
+    }
+
+  private:
+    mpz_t lb, span, r;
+    size_t nlimbs;
+    mp_limb_t top_mask;
+};
+
+// Uniform integers in [lb, ub] when both fit in an int64_t.  This draws the
+// same numbers as mpz_uniform from the same stream.
+class int64_uniform {
+  public:
+    int64_uniform (int64_t lb, int64_t ub) : lb (lb), range ((uint64_t) ub - (uint64_t) lb + 1) { }
+
+    int64_t operator() (counter_rng& rng) {
+      return lb + rng.below (range);
+    }
+
+  private:
+    uint64_t lb, range;
+};
+
+//////////////////// Random successors
+
+// Draws k distinct integers in [0, m), k <= m, with Floyd's algorithm, and
+// stores them sorted in out.  Membership is tested by a linear scan when k is
+// small, which is the case of the usual outdegrees.
+void sample_sorted (counter_rng& rng, uint64_t m, uint64_t k, std::vector<uint64_t>& out) {
+  out.clear ();
+  if (k <= 64)
+    for (uint64_t j = m - k; j < m; ++j) {
+      auto t = rng.below (j + 1);
+      out.push_back (std::find (out.begin (), out.end (), t) == out.end () ? t : j);
+    }
+  else {
+    edge_set seen (m, k);
+    for (uint64_t j = m - k; j < m; ++j) {
+      auto t = rng.below (j + 1);
+      if (not seen.insert (0, t)) {
+        t = j;
+        seen.insert (0, t);
+      }
+      out.push_back (t);
+    }
+  }
+  std::sort (out.begin (), out.end ());
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 #define die(S)                                  \
@@ -118,6 +215,578 @@ instantiate (mpfr_math_expr::all_exprs);
   exit (2);                                     \
   } while (0)
 
+//////////////////// Random games
+
+// The options of a series of games that are expressions, e.g., --maxp '2^size'.
+struct game_exprs {
+    long_math_expr size { "size", "100" },
+      edges { "edges", "min (4 * size, size * (size - 1))" },
+      outdegree { "outdegree", "undefined" },
+      seed { "seed", std::to_string (std::random_device () ()) };
+    mpfr_math_expr maxp { "maxp", "size" };
+};
+
+// The parameters of a series of games, once the expressions are evaluated.
+struct game_params {
+    long n = 0;          // Number of vertices
+    long k = 0;          // Outdegree, or 0 to draw `edges` edges
+    long edges = 0;      // Number of edges, k * n with an outdegree
+    uint64_t seed = 0;
+    std::string maxp;    // Decimal
+    bool energy = false, on_edge = false, bipartite = true, streaming = false, pgb = false;
+
+    // Whether the edges can be drawn when player 0 owns n0 vertices.
+    bool feasible (uint64_t n0) const {
+      uint64_t n1 = n - n0;
+      if (k)
+        return (uint64_t) k <= (bipartite ? std::min (n0, n1) : n);
+      return (uint64_t) edges <= (bipartite ? 2 * n0 * n1 : n * n);
+    }
+};
+
+// Evaluates the expressions into p, whose flags are already set.  Returns
+// what is wrong with the parameters, or an empty string.
+//
+// Feasibility analysis.  Both players own a vertex, and the number of edges
+// a game can have only depends on the number n0 of vertices of player 0.
+// Parameters that no owner split can satisfy are rejected here; owner draws
+// that cannot satisfy them are redrawn before any edge is drawn.  The
+// balanced split is the most permissive one, and its probability is about
+// sqrt (2 / (pi * n)), so few redraws are needed.
+std::string evaluate (game_exprs& e, bool has_outdegree, game_params& p) {
+  std::ostringstream err;
+  if (e.size > std::numeric_limits<vertex_t>::max ())
+    return "size too large";
+  p.n = e.size;
+  p.k = has_outdegree ? *e.outdegree : 0;
+  p.edges = p.k ? p.k * p.n : *e.edges;
+  p.seed = e.seed;
+
+  const long n = p.n, k = p.k;
+  if (n < 2)
+    return "size should be at least 2, so that both players own a vertex";
+  if (has_outdegree and k < 1)
+    return "outdegree should be positive";
+  if (p.streaming and not k)
+    return "stream is only available with outdegree";
+  if (p.pgb and p.streaming)
+    return "stream is not available with the pgb format, which is written from memory";
+  if (p.edges < 0)
+    return "edges should not be negative";
+
+  if (not p.feasible (n / 2)) {
+    if (k and p.bipartite)
+      err << "outdegree " << k << " is larger than " << n / 2 << ", the most successors "
+          "all the vertices of a bipartite game with " << n << " vertices can have";
+    else if (k)
+      err << "outdegree " << k << " is larger than the number of vertices " << n;
+    else if (p.bipartite)
+      err << "edges " << p.edges << " is larger than " << 2 * (n / 2) * (n - n / 2)
+          << ", the most edges of a bipartite game with " << n << " vertices";
+    else
+      err << "edges " << p.edges << " is larger than " << n * n
+          << ", the most edges of a game with " << n << " vertices";
+    return err.str ();
+  }
+
+  mpz_t ub;
+  mpz_init (ub);
+  mpfr_get_z (ub, (*e.maxp).mpfr_srcptr (), MPFR_RNDN);
+  if (mpz_sgn (ub) < 0)
+    err << "maxp should not be negative";
+  else
+    p.maxp = mpz_get_str (nullptr, 10, ub);
+  mpz_clear (ub);
+  return err.str ();
+}
+
+// Game number i of a series.  Each part of a game has its own random stream,
+// keyed by (seed, game, attempt, stream, position in the game), see
+// counter-rng.hh.  The stream tag is always the fourth word, so that the
+// streams of different parts never share a key.  Hence a game does not
+// depend on the number of jobs, and any game can be generated alone.
+class random_game {
+  public:
+    // Draws the owners, until both players own enough vertices, and without
+    // an outdegree, the edges.
+    random_game (const game_params& params, long i) :
+      p (params), i (i), owner (p.streaming ? 0 : p.n), owners ({}) {
+      const long n = p.n;
+      uint64_t n0;
+      for (; ; ++attempt) {
+        counter_rng rnd ({ p.seed, (uint64_t) i, (uint64_t) attempt, OWNERS });
+        uint8_t has_players = 0b00;
+        n0 = 0;
+        for (long j = 0; j < n; ++j) {
+          int32_t o = rnd () >> 63;
+          has_players |= 1 << o;
+          if (j == n - 1 and has_players != 0b11) // force that the two players are there
+            o = !o;
+          if (not p.streaming)
+            owner[j] = o;
+          last_owner = o;
+          n0 += o == 0;
+        }
+        if (p.feasible (n0))
+          break;
+      }
+
+      // With --stream, the owners are not stored, but drawn again from
+      // their stream.
+      owners = counter_rng ({ p.seed, (uint64_t) i, (uint64_t) attempt, OWNERS });
+
+      // Vertices of each player, to draw bipartite edges directly.
+      if (p.bipartite and not p.streaming)
+        for (long j = 0; j < n; ++j)
+          part[owner[j]].push_back (j);
+
+      // With --outdegree, the successors of each vertex are only drawn when
+      // the vertex is written.  Otherwise, pick exactly p.edges distinct
+      // edges among the m possible ones, numbered as below, using Floyd's
+      // algorithm: one draw per edge, whatever the density.
+      if (p.k)
+        return;
+      uint64_t n1 = n - n0;
+      uint64_t m = p.bipartite ? 2 * n0 * n1 : n * n;
+
+      auto edge = [&] (uint64_t idx) -> std::pair<vertex_t, vertex_t> {
+        if (not p.bipartite)
+          return { idx / n, idx % n };
+        if (idx < n0 * n1)
+          return { part[0][idx / n1], part[1][idx % n1] };
+        idx -= n0 * n1;
+        return { part[1][idx / n0], part[0][idx % n0] };
+      };
+
+      csr_builder builder (n, p.edges);
+      counter_rng rnd ({ p.seed, (uint64_t) i, (uint64_t) attempt, EDGES });
+      for (uint64_t j = m - p.edges; j < m; ++j) {
+        auto [from, to] = edge (rnd.below (j + 1));
+        if (not builder.insert (from, to)) {
+          std::tie (from, to) = edge (j);
+          builder.insert (from, to);
+        }
+      }
+      builder.build (game);
+    }
+
+    // Writes the game, drawing the weights and, with an outdegree, the
+    // successors of each vertex as it goes.  Weights are drawn with native
+    // integers when they fit, and GMP otherwise; both draw the same numbers
+    // from the same random streams.
+    void write (text_writer& out) {
+      mpz_t lb, ub;
+      mpz_inits (lb, ub, nullptr);
+      mpz_set_str (ub, p.maxp.c_str (), 10);
+      if (p.energy)
+        mpz_neg (lb, ub);
+      if (mpz_fits_slong_p (lb) and mpz_fits_slong_p (ub)) {
+        int64_uniform rnd_weight (mpz_get_si (lb), mpz_get_si (ub));
+        write (out, rnd_weight, false);
+      }
+      else {
+        mpz_uniform rnd_weight (lb, ub);
+        write (out, rnd_weight, true);
+      }
+      mpz_clears (lb, ub, nullptr);
+    }
+
+  private:
+    enum stream : uint64_t { OWNERS, EDGES, SUCCESSORS, WEIGHTS };
+
+    int32_t owner_of (uint64_t v) {
+      if (not p.streaming)
+        return owner[v];
+      if (v == (uint64_t) p.n - 1)
+        return last_owner;
+      owners.seek (v);
+      return owners () >> 63;
+    }
+
+    template <typename Uniform>
+    void write (text_writer& out, Uniform& rnd_weight, bool bignum) {
+      const long n = p.n, k = p.k;
+      std::vector<uint64_t> succ_idx;
+      std::vector<vertex_t> succ;
+
+      // In pgb format, the game is built in memory and written at the end.
+      pgb_writer bin (p.on_edge ? PGB_ENERGY : PGB_PARITY, bignum);
+      if (not p.pgb)
+        out << (p.on_edge ? "energy " : "parity ") << n << ";\n";
+
+      for (long j = 0; j < n; ++j) {
+        counter_rng weights ({ p.seed, (uint64_t) i, (uint64_t) attempt, WEIGHTS, (uint64_t) j });
+
+        auto oj = owner_of (j);
+        if (p.pgb) {
+          bin.vertex (oj);
+          if (not p.on_edge)
+            bin.label (rnd_weight (weights));
+        }
+        else {
+          out << j << ' ';
+          if (not p.on_edge)
+            out << rnd_weight (weights) << ' ';
+          out << oj << ' ';
+        }
+
+        if (k and p.streaming) {
+          // Rejection sampling, which is fine for the small outdegrees of
+          // the large games that need streaming.
+          counter_rng rnd ({ p.seed, (uint64_t) i, (uint64_t) attempt, SUCCESSORS, (uint64_t) j });
+          succ.clear ();
+          while (succ.size () < (uint64_t) k) {
+            vertex_t to = rnd.below (n);
+            if ((p.bipartite and owner_of (to) == oj) or
+                std::find (succ.begin (), succ.end (), to) != succ.end ())
+              continue;
+            succ.push_back (to);
+          }
+          std::sort (succ.begin (), succ.end ());
+        }
+        else if (k) {
+          counter_rng rnd ({ p.seed, (uint64_t) i, (uint64_t) attempt, SUCCESSORS, (uint64_t) j });
+          auto& dst = part[!oj];
+          sample_sorted (rnd, p.bipartite ? dst.size () : n, k, succ_idx);
+          succ.clear ();
+          for (auto idx : succ_idx)
+            succ.push_back (p.bipartite ? dst[idx] : idx);
+        }
+
+        bool first = true;
+        for (auto&& s : k ? std::span<const vertex_t> (succ) : game.succ (j)) {
+          if (p.pgb) {
+            bin.edge (s);
+            if (p.on_edge)
+              bin.label (rnd_weight (weights));
+            continue;
+          }
+          if (not first) out << ',';
+          out << s;
+          if (p.on_edge)
+            out << ' ' << rnd_weight (weights);
+          first = false;
+        }
+        if (not p.pgb)
+          out << ";\n";
+      }
+
+      if (p.pgb)
+        bin.write (out);
+    }
+
+    const game_params& p;
+    long i, attempt = 0;
+    int32_t last_owner = 0;
+    std::vector<int32_t> owner;
+    std::vector<vertex_t> part[2];
+    csr_graph game;
+    counter_rng owners;
+};
+
+//////////////////// Plans
+//
+// A plan lists series of games in a TOML file (see toml.hh), for instance:
+//
+//     seed = 42                     # Options, as on the command line
+//     count = 10
+//     output = "{dens}/{dens}-sz={size}-{i}.pg"
+//     [dens.sparse]                 # Value "sparse" of the axis "dens"
+//     outdegree = 2
+//     size = [10000, 12500, 15000]
+//     [dens.dense]
+//     edges = "size * size * 0.2"
+//     size = [1000, 1250]
+//
+// The top-level options apply to every series, and a table [axis.value]
+// gives the options of one value of an axis, overriding them.  The plan has
+// a series for each combination of one value per axis, and an option given
+// as an array is one more axis, whose values are its items.  In the output,
+// relative to the folder of the plan, {axis} is replaced by the name of the
+// value, {option} by the option as written, and {i} by the game number.
+// The seed must be given, so that running the plan again makes the same
+// games.  energy-games/energy-games.toml is the plan of the collection.
+//
+// The games are generated in parallel, largest first, each into a temporary
+// file that is then renamed, so that a game under its final name is
+// complete.  The manifest, the plan with extension .manifest, has a line per
+// game made, with a hash of its parameters and its size; a game is only
+// generated if it is not there, or was made with other parameters.  Hence,
+// after a crash, running the plan again only makes the missing games.
+
+// Increase when the games drawn for the same parameters change, so that
+// plans make them again.
+constexpr int GAMES_VERSION = 2;
+
+const char* MANIFEST_COLUMNS = "#path\thash\tbytes";
+
+std::string params_hash (const game_params& p, long i) {
+  std::ostringstream s;
+  s << "random-game-generator " << GAMES_VERSION << '\t' << p.n << '\t' << p.k << '\t'
+    << p.edges << '\t' << p.seed << '\t' << p.maxp << '\t' << p.energy << p.on_edge
+    << p.bipartite << p.streaming << p.pgb << '\t' << i;
+  content_hash h;
+  h.update (s.str ());
+  return content_hash::hex (h.digest ());
+}
+
+// Rough size of the output, to generate the largest games first.
+uint64_t output_size (const game_params& p) {
+  uint64_t vertex_digits = std::to_string (p.n).size (), weight_digits = p.maxp.size () + p.energy;
+  return p.n * (vertex_digits + 4 + (p.on_edge ? 0 : weight_digits))
+    + p.edges * (vertex_digits + 1 + (p.on_edge ? weight_digits + 1 : 0));
+}
+
+void run_plan (const std::string& plan_path, unsigned jobs, game_exprs& exprs) {
+  namespace fs = std::filesystem;
+  std::vector<toml_table> tables;
+  {
+    std::ifstream in (plan_path);
+    if (not in) die (plan_path << ": cannot open file");
+    std::stringstream text;
+    text << in.rdbuf ();
+    std::string err;
+    if (not parse_toml (text.str (), tables, err)) die (plan_path << ": " << err);
+  }
+
+  // Combinations of one value per axis, then of one item per array.
+  using options_t = std::vector<std::pair<std::string, toml_value>>;
+  struct combination {
+      std::vector<std::pair<std::string, std::string>> names; // Axis, value
+      options_t options;
+  };
+  std::vector<std::string> axes;
+  std::vector<std::vector<const toml_table*>> values;
+  for (size_t t = 1; t < tables.size (); ++t) {
+    auto& name = tables[t].name;
+    auto dot = name.find ('.');
+    if (dot == std::string::npos or name.find ('.', dot + 1) != std::string::npos)
+      die (plan_path << ": line " << tables[t].line << ": tables should be named [axis.value]");
+    auto axis = name.substr (0, dot);
+    auto a = std::find (axes.begin (), axes.end (), axis) - axes.begin ();
+    if (a == (long) axes.size ()) {
+      axes.push_back (axis);
+      values.emplace_back ();
+    }
+    values[a].push_back (&tables[t]);
+  }
+
+  auto set = [] (options_t& opts, const std::string& key, const toml_value& v) {
+    for (auto&& [k, w] : opts)
+      if (k == key) {
+        w = v;
+        return;
+      }
+    opts.emplace_back (key, v);
+  };
+  std::vector<combination> combos = { { {}, tables[0].entries } };
+  for (size_t a = 0; a < axes.size (); ++a) {
+    std::vector<combination> next;
+    for (auto&& c : combos)
+      for (auto t : values[a]) {
+        auto d = c;
+        d.names.emplace_back (axes[a], t->name.substr (axes[a].size () + 1));
+        for (auto&& [k, v] : t->entries)
+          set (d.options, k, v);
+        next.push_back (std::move (d));
+      }
+    combos = std::move (next);
+  }
+  for (size_t o = 0; ; ++o) {
+    bool more = false;
+    std::vector<combination> next;
+    for (auto&& c : combos) {
+      more |= o < c.options.size ();
+      if (o >= c.options.size () or c.options[o].second.kind != toml_value::ARRAY) {
+        next.push_back (c);
+        continue;
+      }
+      for (auto&& item : c.options[o].second.items) {
+        if (item.kind == toml_value::ARRAY)
+          die (plan_path << ": " << c.options[o].first << ": nested arrays are not supported");
+        auto d = c;
+        d.options[o].second = item;
+        next.push_back (std::move (d));
+      }
+    }
+    combos = std::move (next);
+    if (not more)
+      break;
+  }
+
+  // Series, and their games.
+  struct job {
+      size_t series;
+      long i;
+      std::string path, hash;
+      uint64_t size;
+  };
+  std::map<std::string, std::string> defaults;
+  for (auto&& [name, e] : mpfr_math_expr::all_exprs)
+    defaults[name] = e.get ().get_value_str ();
+  const std::vector<std::string> flags = { "energy", "on-edge", "bipartite", "stream" };
+  std::vector<game_params> series;
+  std::vector<job> games;
+  std::set<std::string> paths;
+  for (auto&& c : combos) {
+    std::string where = plan_path + ":";
+    for (auto&& [axis, value] : c.names)
+      where += " " + axis + "=" + value;
+    std::map<std::string, std::string> opt;
+    for (auto&& [k, v] : c.options) {
+      bool flag = std::find (flags.begin (), flags.end (), k) != flags.end ();
+      if (not defaults.contains (k) and not flag and k != "count" and k != "format" and k != "output")
+        die (where << ": unknown option " << k);
+      if (flag != (v.kind == toml_value::BOOLEAN))
+        die (where << ": " << k << (flag ? " should be true or false" : " should not be a boolean"));
+      opt[k] = v.text;
+      if (v.kind != toml_value::STRING and k != "count" and not flag)
+        where += " " + k + "=" + v.text;
+    }
+    if (not opt.contains ("output")) die (where << ": output should be given");
+    if (not opt.contains ("seed")) die (where << ": seed should be given, for the games to be the same on each run");
+    if (opt.contains ("outdegree") and opt.contains ("edges"))
+      die (where << ": outdegree and edges cannot both be specified");
+    auto format = opt.contains ("format") ? opt["format"] : "pg";
+    if (format != "pg" and format != "pgb") die (where << ": format should be pg or pgb");
+
+    game_params p;
+    p.energy = opt["energy"] == "true";
+    p.on_edge = opt["on-edge"] == "true";
+    p.bipartite = opt["bipartite"] != "false";
+    p.streaming = opt["stream"] == "true";
+    p.pgb = format == "pgb";
+    for (auto&& [name, e] : mpfr_math_expr::all_exprs)
+      e.get ().set_value_str (opt.contains (name) ? opt[name] : defaults[name]);
+    std::string err;
+    try {
+      err = evaluate (exprs, opt.contains ("outdegree"), p);
+    }
+    catch (const std::exception& e) {
+      err = std::string ("invalid expression: ") + e.what ();
+    }
+    if (not err.empty ()) die (where << ": " << err);
+    long count = opt.contains ("count") ? std::stol (opt["count"]) : 100;
+    if (count < 0) die (where << ": count should not be negative");
+
+    series.push_back (p);
+    for (long i = 0; i < count; ++i) {
+      auto path = opt["output"];
+      boost::algorithm::replace_all (path, "{i}", std::to_string (i));
+      for (auto&& [axis, value] : c.names)
+        boost::algorithm::replace_all (path, "{" + axis + "}", value);
+      for (auto&& [k, v] : opt)
+        boost::algorithm::replace_all (path, "{" + k + "}", v);
+      if (path.find ('{') != std::string::npos)
+        die (where << ": unknown placeholder in output " << path);
+      if (not paths.insert (path).second)
+        die (where << ": two games are written to " << path);
+      games.push_back ({ series.size () - 1, i, path, params_hash (p, i), output_size (p) });
+    }
+  }
+
+  // The games already made, according to the manifest.
+  fs::path dir = fs::path (plan_path).parent_path ();
+  std::string manifest_path = fs::path (plan_path).replace_extension (".manifest");
+  std::map<std::string, std::pair<std::string, uint64_t>> made; // Path -> hash, bytes
+  {
+    std::ifstream in (manifest_path);
+    std::string line;
+    if (std::getline (in, line) and line != MANIFEST_COLUMNS)
+      in.setstate (std::ios::failbit);
+    while (std::getline (in, line)) {
+      std::istringstream is (line);
+      std::string path, hash;
+      uint64_t bytes;
+      std::getline (is, path, '\t');
+      std::getline (is, hash, '\t');
+      if (is >> bytes)
+        made[path] = { hash, bytes };
+    }
+  }
+  auto save_manifest = [&] {
+    auto tmp = manifest_path + ".tmp";
+    {
+      std::ofstream out (tmp);
+      out << MANIFEST_COLUMNS << "\n";
+      for (auto&& [path, m] : made)
+        out << path << '\t' << m.first << '\t' << m.second << "\n";
+      if (not out.flush ()) die (tmp << ": write error");
+    }
+    if (std::rename (tmp.c_str (), manifest_path.c_str ()) != 0)
+      die (manifest_path << ": cannot replace the manifest");
+  };
+
+  std::vector<job*> todo;
+  for (auto&& g : games) {
+    auto m = made.find (g.path);
+    std::error_code ec;
+    if (m == made.end () or m->second.first != g.hash or fs::file_size (dir / g.path, ec) != m->second.second)
+      todo.push_back (&g);
+  }
+  std::sort (todo.begin (), todo.end (), [] (auto a, auto b) { return a->size > b->size; });
+  std::cerr << plan_path << ": " << games.size () << " games in " << series.size () << " series, "
+            << games.size () - todo.size () << " already made\n";
+  // Temporary files left by an interrupted run are removed.
+  for (auto g : todo) {
+    std::error_code ec;
+    fs::create_directories ((dir / g->path).parent_path (), ec);
+    if (ec) die ((dir / g->path).parent_path ().string () << ": " << ec.message ());
+    fs::remove ((dir / g->path).string () + ".tmp", ec);
+  }
+
+  // Each game is recorded as soon as it is made, so that the manifest is
+  // up to date if the run is interrupted.  After an error, the games not
+  // started yet are skipped, and the error is reported once the games being
+  // written are done.
+  save_manifest ();
+  std::ofstream manifest (manifest_path, std::ios::app);
+  std::mutex progress_mtx;
+  size_t done = 0;
+  std::string error;
+  std::atomic<bool> failed = false;
+  parallel_for (todo.size (), jobs, [&] (size_t t) {
+    if (failed)
+      return;
+    auto& g = *todo[t];
+    random_game game (series[g.series], g.i);
+    auto path = (dir / g.path).string (), tmp = path + ".tmp";
+    std::string err;
+    text_writer out (tmp);
+    if (not out.good ())
+      err = tmp + ": cannot open file for writing";
+    else {
+      game.write (out);
+      if (not out.close ())
+        err = tmp + ": write error";
+      else if (std::rename (tmp.c_str (), path.c_str ()) != 0)
+        err = path + ": cannot rename " + tmp;
+    }
+
+    std::error_code ec;
+    if (not err.empty ())
+      fs::remove (tmp, ec);
+    uint64_t bytes = err.empty () ? fs::file_size (path, ec) : 0;
+    std::lock_guard lock (progress_mtx);
+    if (not err.empty ()) {
+      made.erase (g.path);
+      if (not failed.exchange (true))
+        error = err;
+      return;
+    }
+    made[g.path] = { g.hash, bytes };
+    manifest << g.path << '\t' << g.hash << '\t' << bytes << std::endl;
+    std::cerr << "\rgame " << ++done << "/" << todo.size () << "... ";
+  });
+  manifest.close ();
+  save_manifest ();
+  std::cerr << "\n";
+  if (failed)
+    die (error << ", exiting");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void usage (const cxxopts::Options& opts, const std::string& err = "") {
   if (not err.empty ())
     std::cout << err << "\n\n";
@@ -145,14 +814,12 @@ int main (int argc, char** argv) {
 
   cxxopts::Options opts (argv[0], "Generate random games");
 
-  long count = 100;
-  long_math_expr size ("size", "100"),
-    edges ("edges", "min (4 * size, size * (size - 1))"),
-    outdegree ("outdegree", "undefined"),
-    seed ("seed", std::to_string (std::random_device () ()));
-  mpfr_math_expr maxp ("maxp", "size");
-
-  bool energy = false, on_edge = false, bipartite = true;
+  long count = 100, only = 0;
+  std::string range, plan;
+  unsigned jobs = 1;
+  std::string format = "pg";
+  game_exprs exprs;
+  game_params params;
 
   opts.custom_help ("[OPTIONS...] [FILE-PATTERN]\n"
                     "FILE-PATTERN is a filename that may contain placeholders that correspond\n"
@@ -162,142 +829,122 @@ int main (int argc, char** argv) {
   opts.add_options()
     ("h,help", "Print help")
 
+    ("plan", "Generate the series of games listed in a TOML file, in parallel, skipping the "
+     "games already made; see random-game-generator.cc.  Only --jobs may be given with it",
+     cxxopts::value (plan))
+
     ("count", "Number of random games (default: " + std::to_string (count) + ")",
      cxxopts::value (count))
 
+    ("only", "Only generate game number i (default: all)",
+     cxxopts::value (only))
+
+    ("range", "Only generate the games numbered a to b-1, given as a:b (default: 0:count)",
+     cxxopts::value (range))
+
+    ("jobs", "Number of games generated in parallel, 0 for one per core (default: " + std::to_string (jobs) +
+     ", 0 with --plan)",
+     cxxopts::value (jobs))
+
     ("seed", "Seed for the random seed generator (default: random)",
-     cxxopts::value (seed) )
+     cxxopts::value (exprs.seed) )
 
-    ("size", "Size (number of vertices) of each random game (default: " + size.get_value_str () + ")",
-     cxxopts::value (size))
+    ("size", "Size (number of vertices) of each random game (default: " + exprs.size.get_value_str () + ")",
+     cxxopts::value (exprs.size))
 
-    ("maxp", "Maximum priority/weight of a vertex of each random game (default: " + maxp.get_value_str () + ")",
-     cxxopts::value (maxp))
+    ("maxp", "Maximum priority/weight of a vertex of each random game (default: " + exprs.maxp.get_value_str () + ")",
+     cxxopts::value (exprs.maxp))
 
-    ("edges", "Number of edges of each random game (default: " + edges.get_value_str () + ")",
-     cxxopts::value (edges))
+    ("edges", "Number of edges of each random game (default: " + exprs.edges.get_value_str () + ")",
+     cxxopts::value (exprs.edges))
 
-    ("outdegree", "Number of out edges per vertex (default: " + outdegree.get_value_str () + ")",
-     cxxopts::value (outdegree))
+    ("outdegree", "Number of out edges per vertex (default: " + exprs.outdegree.get_value_str () + ")",
+     cxxopts::value (exprs.outdegree))
 
-    ("energy", "Energy game, weight can be negative (default: " + std::to_string (energy) + ")",
-     cxxopts::value (energy))
+    ("energy", "Energy game, weight can be negative (default: " + std::to_string (params.energy) + ")",
+     cxxopts::value (params.energy))
 
-    ("on-edge", "Weight are on edges (default: " + std::to_string (on_edge) + ")",
-     cxxopts::value (on_edge))
+    ("on-edge", "Weight are on edges (default: " + std::to_string (params.on_edge) + ")",
+     cxxopts::value (params.on_edge))
 
-    ("bipartite", "Force the generate graph to be bipartite (default: " + std::to_string (bipartite) + ")",
-     cxxopts::value (bipartite));
+    ("bipartite", "Force the generate graph to be bipartite (default: " + std::to_string (params.bipartite) + ")",
+     cxxopts::value (params.bipartite))
+
+    ("stream", "With --outdegree, use memory independent of the size: owners are recomputed "
+     "when needed, and successors are drawn among all the vertices and rejected if they are "
+     "already taken or, with --bipartite, have the same owner; games differ from the ones "
+     "generated without this option (default: " + std::to_string (params.streaming) + ")",
+     cxxopts::value (params.streaming))
+
+    ("format", "Output format: pg for PGSolver text, pgb for the binary format of pgb.hh (default: " + format + ")",
+     cxxopts::value (format));
 
   opts.allow_unrecognised_options();
   auto options = opts.parse(argc, argv);
 
   if (options.count ("help")) usage (opts);
 
-  std::mt19937 generator (seed);
-  auto rnd = [&] (long lb, long ub) {
-    std::uniform_int_distribution distrib (lb, ub);
-    return distrib (generator);
-  };
-
-  mpfr::random (seed);
-  auto rnd_mpfr = [&] (mpreal lb, mpreal ub) {
-    return mpfr::random () * (ub - lb + 1) + lb;
-  };
-
   auto unmatched = options.unmatched ();
+  if (options.count ("plan")) {
+    for (auto&& opt : options.arguments ())
+      if (opt.key () != "plan" and opt.key () != "jobs")
+        usage (opts, "only jobs may be given with plan.");
+    if (unmatched.size ()) usage (opts, "no filename pattern may be given with plan.");
+    run_plan (plan, options.count ("jobs") ? jobs : 0, exprs);
+    return 0;
+  }
   if (unmatched.size () > 1) usage (opts, "only one filename pattern may be provided");
 
   if (options.count ("outdegree") and options.count ("edges"))
     usage (opts, "outdegree and edges connot both be specified.");
 
-  std::streambuf* buf = std::cout.rdbuf ();
-  long retries = 0;
-  bool retry = false;
-
-  for (long i = 0; i < (long) count; retry or ++i) {
-    if (retry) {
-      retry = false;
-      if (++retries > size * size)
-        die ("games with these parameters are too rare");
-    }
-    else {
+  long first_game = 0, last_game = count;
+  if (options.count ("only") and options.count ("range"))
+    usage (opts, "only and range connot both be specified.");
+  if (options.count ("only"))
+    first_game = only, last_game = only + 1;
+  if (options.count ("range")) {
+    auto colon = range.find (':');
+    if (colon == std::string::npos) usage (opts, "range should be of the form a:b");
+    first_game = std::stol (range.substr (0, colon));
+    last_game = std::stol (range.substr (colon + 1));
+  }
+  if (first_game < 0 or first_game > last_game)
+    usage (opts, "invalid range of games");
+
+  // Evaluate all the expressions before the workers start.
+  if (format != "pg" and format != "pgb")
+    die ("format should be pg or pgb");
+  params.pgb = format == "pgb";
+  auto err = evaluate (exprs, options.count ("outdegree"), params);
+  if (not err.empty ())
+    die (err);
+
+  std::mutex progress_mtx;
+  turnstile stdout_turn;
+  parallel_for (last_game - first_game, jobs, [&] (long nth) {
+    long i = first_game + nth;
+    {
+      std::lock_guard lock (progress_mtx);
       std::cerr << "\rgame " << i << "... ";
-      retries = 0;
     }
 
-    // Generate game
-    struct vert {
-        int32_t owner;
-        std::set<long> succ;
-    };
-    auto game = new vert[*size];
-
-    uint8_t has_players = 0b00;
-    for (long j = 0; j < size; ++j) {
-      game[j].owner = rnd (0, 1);
-      has_players |= 1 << game[j].owner;
-      if (j == size - 1 and has_players != 0b11) // force that the two players are there
-        game[j].owner = !game[j].owner;
-    }
-
-    long attempts = 0;
-    long actual_edges = options.count ("outdegree") ? outdegree * size : edges;
-    for (long j = 0; j < actual_edges; ++j) {
-      long from = 0, to = 0;
-      if (options.count ("outdegree"))
-        from = j / outdegree;
-      attempts = size * size;
-      do {
-        attempts--;
-        if (not options.count ("outdegree"))
-          from = rnd (0, size - 1);
-        to = rnd (0, size - 1);
-      } while (attempts > 0 and
-               (game[from].succ.contains (to) or (bipartite and (game[from].owner == game[to].owner))));
-      if (attempts == 0)
-        break;
-      game[from].succ.insert (to);
-    }
-
-    if (attempts == 0) {
-      retry = true;
-      continue;
-    }
+    random_game game (params, i);
 
     // Dump game
-    std::ofstream of;
-    if (unmatched.size ()) {
-      auto fn = make_filename (unmatched[0], options, i);
-      of.open (fn);
-      if (not of.good ()) die (fn + ": cannot open file for writing, exiting");
-      buf = of.rdbuf ();
-    }
-
-    std::ostream out (buf);
-    if (on_edge)
-      out << "energy " << size << ";\n";
+    std::string fn;
+    if (unmatched.size ())
+      fn = make_filename (unmatched[0], options, i);
     else
-      out << "parity " << size << ";\n";
-
-    for (long j = 0; j < size; ++j) {
-
-      out << j << " ";
-      if (not on_edge)
-        out << rnd_mpfr ((energy ? -1 : 0) * *maxp, *maxp).toString ("%.0RNf") << " ";
-
-      out << game[j].owner << " ";
-
-      bool first = true;
-      for (auto&& s : game[j].succ) {
-        out << (first ? "" : ",") << s;
-        if (on_edge)
-          out << " " << rnd_mpfr ((energy ? -1 : 0) * *maxp, *maxp).toString ("%.0RNf");
-        first = false;
-      }
-      out << ";\n";
-    }
-    delete[] game;
-  }
+      stdout_turn.wait (nth);
+
+    text_writer out = fn.empty () ? text_writer (1) : text_writer (fn);
+    if (not out.good ()) die (fn + ": cannot open file for writing, exiting");
+    game.write (out);
+    if (not out.close ())
+      die ((fn.empty () ? "stdout" : fn) + ": write error, exiting");
+    if (fn.empty ())
+      stdout_turn.next ();
+  });
   std::cerr << "\n";
 }
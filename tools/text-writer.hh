@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <concepts>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <gmp.h>
+
+//////////////////// Buffered text output
+//
+// Games are formatted straight into a large buffer, with std::to_chars for
+// native integers and mpz_get_str for GMP integers, and the buffer is handed
+// to write(2) when full.  Nothing is allocated per token.  A text_writer is
+// not thread-safe: each thread uses its own.  A text_writer built without a
+// file keeps everything in memory instead, growing its buffer, so that threads
+// can format parts of a file that are then written in order.
+
+class text_writer {
+  public:
+    static constexpr size_t default_capacity = 1 << 22;
+
+    // Writes to an already open file descriptor, e.g., 1 for stdout.
+    explicit text_writer (int fd, size_t capacity = default_capacity) :
+      fd (fd), buf (capacity) { }
+
+    // Creates or truncates path; check good () before writing.
+    explicit text_writer (const std::string& path, size_t capacity = default_capacity) :
+      fd (::open (path.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666)), owned (true), buf (capacity) {
+      failed = fd < 0;
+    }
+
+    // Keeps the text in memory, see text ().
+    text_writer () : fd (-1), in_memory (true), buf (1 << 16) { }
+
+    text_writer (const text_writer&) = delete;
+
+    ~text_writer () {
+      close ();
+    }
+
+    bool good () const { return not failed; }
+
+    // Writes the buffer out, unless in memory; returns good ().
+    bool flush () {
+      if (in_memory)
+        return good ();
+      write_all ({ buf.data (), pos });
+      pos = 0;
+      return good ();
+    }
+
+    // Flushes and closes the file if it was opened by this writer; returns
+    // good ().
+    bool close () {
+      if (fd >= 0) {
+        flush ();
+        if (owned and ::close (fd) != 0)
+          failed = true;
+        fd = -1;
+      }
+      return good ();
+    }
+
+    text_writer& operator<< (char c) {
+      reserve (1);
+      buf[pos++] = c;
+      return *this;
+    }
+
+    text_writer& operator<< (std::string_view s) {
+      if (in_memory)
+        reserve (s.size ());
+      else if (s.size () > buf.size () - pos) {
+        flush ();
+        if (s.size () > buf.size ()) { // Too large to be worth a copy
+          write_all (s);
+          return *this;
+        }
+      }
+      std::memcpy (buf.data () + pos, s.data (), s.size ());
+      pos += s.size ();
+      return *this;
+    }
+
+    text_writer& operator<< (const char* s) {
+      return *this << std::string_view (s);
+    }
+
+    template <std::integral T>
+    requires (not std::same_as<T, char> and not std::same_as<T, bool>)
+    text_writer& operator<< (T n) {
+      reserve (24);
+      pos = std::to_chars (buf.data () + pos, buf.data () + buf.size (), n).ptr - buf.data ();
+      return *this;
+    }
+
+    text_writer& operator<< (mpz_srcptr z) {
+      // mpz_sizeinbase may overestimate by one, and mpz_get_str writes a
+      // terminating null byte.
+      reserve (mpz_sizeinbase (z, 10) + 2);
+      mpz_get_str (buf.data () + pos, 10, z);
+      pos += std::strlen (buf.data () + pos);
+      return *this;
+    }
+
+    // The text so far of an in-memory writer, valid until the next output.
+    std::string_view text () const { return { buf.data (), pos }; }
+
+    // Empties an in-memory writer, keeping its buffer.
+    void clear () { pos = 0; }
+
+  private:
+    void reserve (size_t n) {
+      if (in_memory and n > buf.size () - pos)
+        buf.resize (std::max (2 * buf.size (), pos + n));
+      else if (n > buf.size () - pos) {
+        flush ();
+        if (n > buf.size ())
+          buf.resize (n);
+      }
+    }
+
+    void write_all (std::string_view s) {
+      while (not s.empty () and not failed) {
+        auto w = ::write (fd, s.data (), s.size ());
+        if (w > 0)
+          s.remove_prefix (w);
+        else if (w == 0 or errno != EINTR) // write () making no progress would loop forever
+          failed = true;
+      }
+    }
+
+    int fd;
+    bool owned = false, failed = false, in_memory = false;
+    std::vector<char> buf;
+    size_t pos = 0;
+};
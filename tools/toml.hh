@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cctype>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+//////////////////// Minimal TOML reader
+//
+// Reads the subset of TOML that the plans of random-game-generator use:
+// comments, tables "[name]" or "[name.sub]", and "key = value" lines, where a
+// value is a string ("basic", with \" \\ \n \t escapes, or 'literal'), a
+// number, true or false, or an array of these, which may span several
+// lines.  Numbers are kept as written, without their underscores, as they
+// are handed to the expression parser anyway.  Keys are bare.  Inline
+// tables, arrays of tables, dates and multi-line strings are not supported.
+
+struct toml_value {
+    enum kind_t { STRING, NUMBER, BOOLEAN, ARRAY } kind = STRING;
+    std::string text;              // The string, or the number or boolean as written
+    std::vector<toml_value> items; // Of an array
+};
+
+struct toml_table {
+    std::string name;                                         // "" for the root table
+    std::vector<std::pair<std::string, toml_value>> entries; // In file order
+    size_t line = 0;                                          // Of the header
+};
+
+inline bool parse_toml (std::string_view text, std::vector<toml_table>& tables, std::string& err) {
+  const char* p = text.data (), *end = p + text.size ();
+  size_t line = 1;
+  auto fail = [&] (const std::string& what) {
+    err = "line " + std::to_string (line) + ": " + what;
+    return false;
+  };
+  auto bare = [] (char c) { return std::isalnum ((unsigned char) c) or c == '_' or c == '-'; };
+  // Skips blanks, and with newlines, also line ends and comments.
+  auto skip = [&] (bool newlines) {
+    while (p != end) {
+      if (*p == ' ' or *p == '\t' or *p == '\r')
+        ++p;
+      else if (*p == '#')
+        while (p != end and *p != '\n')
+          ++p;
+      else if (*p == '\n' and newlines)
+        ++p, ++line;
+      else
+        break;
+    }
+  };
+  auto key = [&] (std::string& k) {
+    const char* q = p;
+    while (p != end and bare (*p))
+      ++p;
+    k.assign (q, p);
+    return not k.empty ();
+  };
+
+  auto value = [&] (auto& self, toml_value& v) -> bool {
+    if (p == end)
+      return fail ("expected a value");
+    if (*p == '"' or *p == '\'') {
+      char quote = *p++;
+      v.kind = toml_value::STRING;
+      for (; p != end and *p != quote and *p != '\n'; ++p) {
+        if (*p != '\\' or quote == '\'') {
+          v.text += *p;
+          continue;
+        }
+        if (++p == end)
+          break;
+        switch (*p) {
+          case '"': case '\\': v.text += *p; break;
+          case 'n': v.text += '\n'; break;
+          case 't': v.text += '\t'; break;
+          default: return fail (std::string ("unknown escape \\") + *p);
+        }
+      }
+      if (p == end or *p != quote)
+        return fail ("unterminated string");
+      ++p;
+      return true;
+    }
+    if (*p == '[') {
+      ++p;
+      v.kind = toml_value::ARRAY;
+      while (skip (true), p != end and *p != ']') {
+        v.items.emplace_back ();
+        if (not self (self, v.items.back ()))
+          return false;
+        skip (true);
+        if (p != end and *p == ',')
+          ++p;
+        else if (p == end or *p != ']')
+          return fail ("expected , or ] in array");
+      }
+      if (p == end)
+        return fail ("unterminated array");
+      ++p;
+      return true;
+    }
+    const char* q = p;
+    while (p != end and (bare (*p) or *p == '.' or *p == '+'))
+      ++p;
+    std::string_view word (q, p - q);
+    if (word == "true" or word == "false") {
+      v.kind = toml_value::BOOLEAN;
+      v.text = word;
+      return true;
+    }
+    if (word.empty () or not (std::isdigit ((unsigned char) word[0]) or word[0] == '-' or word[0] == '+'))
+      return fail ("expected a value");
+    v.kind = toml_value::NUMBER;
+    for (auto c : word)
+      if (c != '_')
+        v.text += c;
+    return true;
+  };
+
+  tables.assign (1, toml_table ());
+  while (skip (true), p != end) {
+    if (*p == '[') {
+      ++p;
+      skip (false);
+      toml_table t;
+      t.line = line;
+      std::string part;
+      while (key (part)) {
+        t.name += (t.name.empty () ? "" : ".") + part;
+        skip (false);
+        if (p == end or *p != '.')
+          break;
+        ++p;
+        skip (false);
+      }
+      if (t.name.empty () or p == end or *p != ']')
+        return fail ("expected [name] or [name.sub]");
+      ++p;
+      for (auto&& u : tables)
+        if (u.name == t.name)
+          return fail ("table [" + t.name + "] defined twice");
+      tables.push_back (std::move (t));
+    }
+    else {
+      std::string k;
+      if (not key (k))
+        return fail ("expected a key");
+      skip (false);
+      if (p == end or *p != '=')
+        return fail ("expected = after " + k);
+      ++p;
+      skip (false);
+      toml_value v;
+      if (not value (value, v))
+        return false;
+      auto& entries = tables.back ().entries;
+      for (auto&& [k2, v2] : entries)
+        if (k2 == k)
+          return fail ("key " + k + " defined twice");
+      entries.emplace_back (k, std::move (v));
+    }
+    skip (false);
+    if (p != end and *p != '\n')
+      return fail ("expected the end of the line");
+  }
+  return true;
+}